@@ -26,11 +26,16 @@
 #include "itensor/mps/dmrg.h"
 #include "itensor/mps/idmrg.h"
 #include "itensor/mps/tevol.h"
+#include "itensor/mps/gatecircuit.h"
+#include "itensor/mps/tdvp.h"
 #include "itensor/mps/hambuilder.h"
 #include "itensor/mps/autompo.h"
+#include "itensor/mps/sharedtensors.h"
+#include "itensor/mps/correlations.h"
 
 #include "itensor/mps/lattice/square.h"
 #include "itensor/mps/lattice/triangular.h"
+#include "itensor/mps/lattice/siteorder.h"
 
 #include "itensor/mps/sites/spinhalf.h"
 #include "itensor/mps/sites/spinone.h"
@@ -8,6 +8,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <ctime>
 #include <stdexcept>
 #include "itensor/types.h"
@@ -72,11 +73,21 @@ contains(const Container& C,
     return false;
     }
 
-//Simple linear congruential random number generator
+//Initial seed of the random number generators of the
+//calling thread, different for each thread
+int inline
+threadSeed()
+    {
+    static std::atomic<int> nthread(0);
+    return int(std::time(NULL) + getpid()) + 7919*(nthread++);
+    }
+
+//Simple linear congruential random number generator,
+//with a separate state for each thread
 inline int&
 seed_quickran(int newseed)
     {
-    static int seed = (std::time(NULL) + getpid());
+    static thread_local int seed = threadSeed();
     if(newseed != 0) seed = newseed;
     return seed;
     }
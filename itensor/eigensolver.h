@@ -38,6 +38,27 @@ davidson(BigMatrixT const& A,
          std::vector<Tensor>& phi,
          Args const& args = Args::global());
 
+//
+// Use the Lanczos algorithm to compute exp(t*A) phi for the
+// Hermitian matrix A and complex number t (for example
+// t = -i*dt to evolve phi in real time by dt), overwriting phi
+// with the result.
+// (BigMatrixT objects must implement the method product.)
+// Returns an estimate of the error of the result.
+//
+// Arguments recognized:
+// o "MaxIter" (default: 30) - maximum dimension of the Krylov space
+// o "ErrGoal" (default: 1E-12) - stop once the error estimate,
+//   relative to the norm of phi, is below this value
+// o "DebugLevel" (default: -1)
+//
+template <class BigMatrixT, class Tensor> 
+Real
+applyExp(BigMatrixT const& A, 
+         Tensor& phi,
+         Cplx t,
+         Args const& args = Args::global());
+
 //
 //
 // Implementations
@@ -406,6 +427,91 @@ davidson(BigMatrixT const& A,
     return eigs;
     }
 
+template <class BigMatrixT, class Tensor> 
+Real
+applyExp(BigMatrixT const& A, 
+         Tensor& phi,
+         Cplx t,
+         Args const& args)
+    {
+    auto maxiter = args.getInt("MaxIter",30);
+    auto errgoal = args.getReal("ErrGoal",1E-12);
+    auto debug_level = args.getInt("DebugLevel",-1);
+    if(maxiter < 1) Error("applyExp: MaxIter must be >= 1");
+
+    auto nrm = norm(phi);
+    if(nrm == 0.) return 0.;
+
+    //Subtract the projection of w onto v, keeping w real if possible
+    auto orthTo = [](Tensor & w, Tensor const& v)
+        {
+        auto z = (dag(v)*w).cplx();
+        if(z.imag() == 0.) w -= z.real()*v;
+        else               w -= z*v;
+        };
+
+    auto V = std::vector<Tensor>{phi/nrm};
+    auto alpha = std::vector<Real>{},
+         beta = std::vector<Real>{};
+    auto c = CVector{};
+    Real err = NAN;
+    for(auto k : range(maxiter))
+        {
+        Tensor w;
+        A.product(V[k],w);
+        alpha.push_back((dag(V[k])*w).cplx().real());
+        //Full reorthogonalization (twice) against the Krylov basis
+        for(auto pass : range(2)) 
+            {
+            (void)pass;
+            for(auto& v : V) orthTo(w,v);
+            }
+        auto b = norm(w);
+
+        //exp(t*T) e_0 for the tridiagonal projection T of A
+        auto n = alpha.size();
+        auto T = Matrix(n,n);
+        for(auto j : range(n))
+            {
+            T(j,j) = alpha[j];
+            if(j+1 < n) T(j,j+1) = T(j+1,j) = beta[j];
+            }
+        Matrix U;
+        Vector d;
+        diagHermitian(T,U,d);
+        c = CVector(n);
+        for(auto j : range(n))
+        for(auto l : range(n))
+            {
+            c(j) += U(j,l)*std::exp(t*d(l))*U(0,l);
+            }
+
+        err = b*std::abs(c(n-1));
+        if(debug_level > 1) printfln("applyExp: iter %d, error estimate %.3E",k+1,err);
+        if(err < errgoal || b < 1E-14 || k+1 == maxiter) break;
+
+        beta.push_back(b);
+        w /= b;
+        w.scaleTo(1.);
+        V.push_back(w);
+        }
+    if(debug_level > 0 && err >= errgoal)
+        {
+        printfln("applyExp: error estimate %.3E above ErrGoal after %d iterations",err,V.size());
+        }
+
+    auto res = Tensor();
+    for(auto j : range(c.size()))
+        {
+        auto z = nrm*c(j);
+        auto term = (z.imag() == 0.) ? z.real()*V[j] : z*V[j];
+        if(!res) res = term;
+        else     res += term;
+        }
+    phi = res;
+    return err;
+    }
+
 } //namespace itensor
 
 #endif
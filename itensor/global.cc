@@ -61,7 +61,8 @@ Global::args(const Args::Name& name, const std::string& sval)
 bool&
 Global::printdat()
     {
-    static bool printdat_ = false;
+    //Per thread, since PrintData sets it temporarily
+    static thread_local bool printdat_ = false;
     return printdat_;
     }
 Real&
@@ -82,8 +83,9 @@ Global::random(int seed)
     using Generator = std::mt19937;
     using Distribution = std::uniform_real_distribution<Real>;
 
-    static Generator rng(std::time(NULL)+getpid());
-    static Distribution dist(0,1);
+    //Each thread has its own generator
+    static thread_local Generator rng(detail::threadSeed());
+    static thread_local Distribution dist(0,1);
 
     if(seed != 0)  //reseed rng
         {
@@ -95,11 +97,10 @@ Global::random(int seed)
 void
 Global::warnDeprecated(const std::string& message)
     {
-    static int depcount = 1;
-    if(depcount <= 10)
+    static std::atomic<int> depcount(1);
+    if(depcount++ <= 10)
         {
         println("\n\n",message,"\n");
-        ++depcount;
         }
     }
 bool&
@@ -81,7 +81,11 @@ const int MAX_M = 5000;
 
 enum Printdat { ShowData, HideData };
 
-
+//
+// Global settings. Except for printdat (which each thread
+// has its own of) they are shared by all threads, so set
+// them before starting threads.
+//
 class Global
     {
     public:
@@ -101,6 +105,8 @@ class Global
     static bool& printdat();
     static Real& printScale();
     static bool& showIDs();
+    //Uniform random number in [0,1) from the generator
+    //of the calling thread, first reseeding it if seed != 0
     static Real random(int seed = 0);
     void static warnDeprecated(const std::string& message);
     static bool& read32BitIDs();
@@ -121,6 +127,8 @@ PrintEither(bool pdat,
     Global::printdat() = savep;
     }
 
+//Seed the random number generators of the calling
+//thread (each thread has its own)
 void inline
 seedRNG(int seed)
     {
@@ -46,11 +46,21 @@ nameint(string const& f, int n)
 
 
 
+namespace detail {
+
+Index::IDGenerator&
+indexIDGenerator()
+    {
+    static thread_local Index::IDGenerator G;
+    return G;
+    }
+
+} //namespace detail
+
 Index::id_type Index::
 generateID()
     {
-    static thread_local Index::IDGenerator G;
-    return G();
+    return detail::indexIDGenerator()();
     }
 
 Index::
@@ -326,6 +336,9 @@ sim(Index const& I, int plev)
 string
 showm(Index const& I) { return nameint("m=",I.m()); }
 
+void
+seedIndexIDs(Index::id_type seed) { detail::indexIDGenerator().seed(seed); }
+
 
 std::ostream& 
 operator<<(std::ostream& s, IndexVal const& iv)
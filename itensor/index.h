@@ -28,6 +28,9 @@ namespace detail {
         result_type
         operator()() { return rng(); }
 
+        void
+        seed(result_type s) { rng.seed(s); }
+
         private:
         rng_type rng;
         };
@@ -46,6 +49,9 @@ namespace detail {
             return res; 
             }
 
+        void
+        seed(result_type s) { id = s; }
+
         private:
         result_type id = 0;
         };
@@ -291,6 +297,18 @@ sim(Index const& I, int plev = 0);
 std::string
 showm(Index const& I);
 
+namespace detail {
+//Generator of Index ids of the calling thread
+Index::IDGenerator&
+indexIDGenerator();
+} //namespace detail
+
+//Reset the generator of Index ids of the calling thread.
+//Processes which reset it with the same seed and then make
+//the same sequence of new Indices give them the same ids.
+void
+seedIndexIDs(Index::id_type seed);
+
 std::string 
 nameint(std::string const& f, int n);
 
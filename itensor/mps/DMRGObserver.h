@@ -16,6 +16,12 @@ namespace itensor {
 // so that behavior can be customized in a
 // derived class.
 //
+// If the named argument "RecordSpectra" is true,
+// the spectrum of the SVD at each bond is kept
+// (the last one computed at that bond) and is
+// returned by spectrum(b). Pass "ComputeQNs" true
+// to dmrg to also record the QN of each eigenvalue.
+//
 
 template<class Tensor>
 class DMRGObserver : public Observer
@@ -42,6 +48,11 @@ class DMRGObserver : public Observer
     Spectrum const&
     spectrum() const { return last_spec_; }
 
+    //Last spectrum recorded at bond b
+    //(requires "RecordSpectra" true)
+    Spectrum const&
+    spectrum(int b) const { return bond_specs_.at(b); }
+
     private:
 
     /////////////
@@ -54,6 +65,8 @@ class DMRGObserver : public Observer
     bool done_;
     Real last_energy_;
     Spectrum last_spec_;
+    bool record_specs_;
+    std::vector<Spectrum> bond_specs_;
 
     /////////////
 
@@ -69,7 +82,9 @@ DMRGObserver(MPSt<Tensor> const& psi, Args const& args)
     max_eigs(-1),
     max_te(-1),
     done_(false),
-    last_energy_(1000)
+    last_energy_(1000),
+    record_specs_(args.getBool("RecordSpectra",false)),
+    bond_specs_(record_specs_ ? psi.N() : 0)
     //default_ops_(psi.sites().defaultOps())
     { 
     }
@@ -103,19 +118,15 @@ measure(Args const& args)
             }
         }
 
+    if(record_specs_ && b > 0 && b < N) bond_specs_.at(b) = last_spec_;
+
     if(printeigs)
         {
         if(b == N/2 && ha == 2)
             {
             println();
             auto center_eigs = last_spec_.eigsKept();
-            Real S = 0;
-            for(auto& p : center_eigs)
-                {
-                if(p > 1E-13) S += p*log(p);
-                }
-            S *= -1;
-            printfln("    vN Entropy at center bond b=%d = %.12f",N/2,S);
+            printfln("    vN Entropy at center bond b=%d = %.12f",N/2,entropy(last_spec_));
             printf(  "    Eigs at center bond b=%d: ",N/2);
             auto ten = decltype(center_eigs.size())(10);
             for(auto j : range(std::min(center_eigs.size(),ten)))
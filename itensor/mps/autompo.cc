@@ -4,9 +4,20 @@
 //
 #include <algorithm>
 #include <map>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
 #include "itensor/util/print_macro.h"
 #include "itensor/mps/autompo.h"
+#include "itensor/mps/sharedtensors.h"
 #include "itensor/tensor/algs.h"
+#include "itensor/util/cputime.h"
+#include "itensor/util/readwrite.h"
+#include "itensor/util/threadpool.h"
 
 using std::find;
 using std::cout;
@@ -360,23 +371,277 @@ operator,(const string& op_)
     return *this;
     }
 
+void
+addTerm(AutoMPO::storage & terms,
+        HTerm const& t)
+    {
+    auto it = terms.find(t);
+    if(it == terms.end())
+        {
+        terms.insert(move(t));
+        }
+    else //found duplicate
+        {
+        auto nt = t;
+        nt.coef += it->coef;
+        terms.erase(it);
+        terms.insert(move(nt));
+        }
+    }
+
 void AutoMPO::
 add(HTerm const& t)
     {
     if(abs(t.coef) == 0.0) return;
+    addTerm(terms_,t);
+    }
 
-    auto it = terms_.find(t);
-    if(it == terms_.end())
+void AutoMPO::
+addLongRange(string const& op1,
+             string const& op2,
+             std::function<Real(int)> const& V)
+    {
+    auto N = sites_.N();
+    auto t = LongRangeTerm{op1,op2,vector<Real>(max(N,1),0.)};
+    for(auto r : range1(N-1)) t.V.at(r) = V(r);
+    longrange_.push_back(move(t));
+    }
+
+int AutoMPO::
+opId(string const& opname)
+    {
+    auto it = opids_.find(opname);
+    if(it != opids_.end()) return it->second;
+    auto id = int(opnames_.size());
+    opnames_.push_back(opname);
+    opfermi_.push_back(isFermionic(SiteTerm(opname,1)));
+    opids_[opname] = id;
+    return id;
+    }
+
+//Lexicographic comparison of rows a and b
+//(each nops (site,op) pairs) of flat terms
+int
+compareRows(int const* sa, int const* oa,
+            int const* sb, int const* ob,
+            int nops)
+    {
+    for(auto k : range(nops))
         {
-        terms_.insert(move(t));
+        if(sa[k] != sb[k]) return sa[k] < sb[k] ? -1 : 1;
+        if(oa[k] != ob[k]) return oa[k] < ob[k] ? -1 : 1;
         }
-    else //found duplicate
+    return 0;
+    }
+
+void AutoMPO::
+addTerms(int nops,
+         vector<Real> const& coefs,
+         vector<int> const& opids,
+         vector<int> const& sites,
+         Args const& args)
+    {
+    addTerms(nops,vector<Cplx>(coefs.begin(),coefs.end()),opids,sites,args);
+    }
+
+void AutoMPO::
+addTerms(int nops,
+         vector<Cplx> const& coefs,
+         vector<int> const& opids,
+         vector<int> const& sites,
+         Args const& args)
+    {
+    if(nops < 1) Error("addTerms: nops must be at least 1");
+    auto nt = coefs.size();
+    if(opids.size() != nt*nops || sites.size() != nt*nops)
         {
-        auto nt = t;
-        nt.coef += it->coef;
-        terms_.erase(it);
-        terms_.insert(move(nt));
+        Error("addTerms: opids and sites must have nops entries per coefficient");
         }
+    auto nthread = args.getInt("NThread",1);
+
+    //Put the operators of each term in site order,
+    //in the same way as HTerm::add
+    auto batch = FlatTerms{};
+    batch.coef.reserve(nt);
+    batch.site.reserve(nt*nops);
+    batch.op.reserve(nt*nops);
+    auto ps = vector<int>(nops),
+         po = vector<int>(nops);
+    for(auto t : range(nt))
+        {
+        auto z = coefs[t];
+        if(abs(z) == 0.0) continue;
+        for(auto k : range(nops))
+            {
+            auto i = sites[t*nops+k];
+            auto o = opids[t*nops+k];
+            if(o < 0 || o >= int(opnames_.size())) Error("addTerms: invalid operator id");
+            auto pos = 0;
+            while(pos < k && ps[pos] <= i) ++pos;
+            if(pos < k && opfermi_[o])
+                {
+                auto isf = false;
+                for(auto q : range(pos,k)) if(opfermi_[po[q]]) isf = !isf;
+                if(isf) z = -z;
+                }
+            for(auto q = k; q > pos; --q) 
+                {
+                ps[q] = ps[q-1];
+                po[q] = po[q-1];
+                }
+            ps[pos] = i;
+            po[pos] = o;
+            }
+        batch.coef.push_back(z);
+        batch.site.insert(batch.site.end(),ps.begin(),ps.end());
+        batch.op.insert(batch.op.end(),po.begin(),po.end());
+        }
+
+    //Sort the rows of the batch, sorting
+    //nthread pieces concurrently then merging
+    auto n = batch.coef.size();
+    auto perm = vector<size_t>(n);
+    for(auto t : range(n)) perm[t] = t;
+    auto lessRow = [&batch,nops](size_t a, size_t b)
+        {
+        return compareRows(&batch.site[a*nops],&batch.op[a*nops],
+                           &batch.site[b*nops],&batch.op[b*nops],nops) < 0;
+        };
+    auto npiece = size_t(nthread > 1 ? nthread : 1);
+    if(n < 10000) npiece = 1;
+    auto bounds = vector<size_t>(npiece+1);
+    for(auto p : range(npiece+1)) bounds[p] = (p*n)/npiece;
+    detail::parallelFor(npiece,[&](size_t p)
+        {
+        std::sort(perm.begin()+bounds[p],perm.begin()+bounds[p+1],lessRow);
+        });
+    for(auto p : range(1,npiece))
+        {
+        std::inplace_merge(perm.begin(),perm.begin()+bounds[p],perm.begin()+bounds[p+1],lessRow);
+        }
+
+    //Merge the sorted batch (summing coefficients of
+    //duplicate rows) with previously added flat terms
+    auto& old = flat_[nops];
+    auto res = FlatTerms{};
+    res.coef.reserve(old.coef.size()+n);
+    res.site.reserve((old.coef.size()+n)*nops);
+    res.op.reserve((old.coef.size()+n)*nops);
+    auto append = [&res,nops](FlatTerms const& F, size_t t)
+        {
+        auto last = res.coef.size();
+        if(last > 0 && 0 == compareRows(&res.site[(last-1)*nops],&res.op[(last-1)*nops],
+                                         &F.site[t*nops],&F.op[t*nops],nops))
+            {
+            res.coef.back() += F.coef[t];
+            return;
+            }
+        res.coef.push_back(F.coef[t]);
+        res.site.insert(res.site.end(),F.site.begin()+t*nops,F.site.begin()+(t+1)*nops);
+        res.op.insert(res.op.end(),F.op.begin()+t*nops,F.op.begin()+(t+1)*nops);
+        };
+    size_t a = 0, b = 0;
+    while(a < old.coef.size() || b < n)
+        {
+        if(b == n || (a < old.coef.size() && 
+           compareRows(&old.site[a*nops],&old.op[a*nops],
+                       &batch.site[perm[b]*nops],&batch.op[perm[b]*nops],nops) <= 0))
+            {
+            append(old,a++);
+            }
+        else
+            {
+            append(batch,perm[b++]);
+            }
+        }
+    old = move(res);
+    }
+
+vector<HTerm> AutoMPO::
+sortedTerms() const
+    {
+    std::lock_guard<std::mutex> lock(flushm_.m);
+    return mergeTerms();
+    }
+
+vector<HTerm> AutoMPO::
+mergeTerms() const
+    {
+    //Rank of each operator name in string order, so that
+    //comparing (site,rank) pairs orders rows as LessNoCoef
+    auto rank = vector<int>(opnames_.size());
+    auto byname = vector<int>(opnames_.size());
+    for(auto o : range(byname.size())) byname[o] = o;
+    std::sort(byname.begin(),byname.end(),
+              [this](int a, int b) { return opnames_[a] < opnames_[b]; });
+    for(auto r : range(byname.size())) rank[byname[r]] = r;
+
+    auto flat = vector<HTerm>();
+    for(auto& nf : flat_)
+        {
+        auto nops = nf.first;
+        auto& F = nf.second;
+        auto perm = vector<size_t>(F.coef.size());
+        for(auto t : range(perm.size())) perm[t] = t;
+        std::sort(perm.begin(),perm.end(),[&F,&rank,nops](size_t a, size_t b)
+            {
+            for(auto k : range(nops))
+                {
+                auto sa = F.site[a*nops+k], sb = F.site[b*nops+k];
+                if(sa != sb) return sa < sb;
+                auto ra = rank[F.op[a*nops+k]], rb = rank[F.op[b*nops+k]];
+                if(ra != rb) return ra < rb;
+                }
+            return false;
+            });
+        for(auto t : perm)
+            {
+            flat.emplace_back(F.coef[t],SiteTermProd{});
+            auto& ops = flat.back().ops;
+            ops.reserve(nops);
+            for(auto k : range(nops))
+                {
+                ops.emplace_back(opnames_[F.op[t*nops+k]],F.site[t*nops+k]);
+                }
+            }
+        }
+
+    //Merge with the other terms, summing the
+    //coefficients of terms present in both
+    auto less = LessNoCoef();
+    auto res = vector<HTerm>();
+    res.reserve(terms_.size()+flat.size());
+    auto a = terms_.begin();
+    auto b = flat.begin();
+    while(a != terms_.end() || b != flat.end())
+        {
+        if(b == flat.end() || (a != terms_.end() && less(*a,*b)))
+            {
+            res.push_back(*a++);
+            }
+        else if(a == terms_.end() || less(*b,*a))
+            {
+            res.push_back(move(*b++));
+            }
+        else
+            {
+            res.push_back(*a++);
+            res.back().coef += b->coef;
+            ++b;
+            }
+        }
+    return res;
+    }
+
+void AutoMPO::
+flush() const
+    {
+    std::lock_guard<std::mutex> lock(flushm_.m);
+    if(flat_.empty()) return;
+    //Built from sorted terms in linear time
+    auto all = mergeTerms();
+    terms_ = storage(std::make_move_iterator(all.begin()),std::make_move_iterator(all.end()));
+    flat_.clear();
     }
 
 /*
@@ -980,7 +1245,7 @@ conj(Real x) { return x; }
 template<typename T>
 void
 partitionHTerms(SiteSet const& sites,
-                AutoMPO::storage const& terms,
+                vector<HTerm> const& terms,
                 vector<QNBlock<T>> & qbs, 
                 vector<IQMatEls> & tempMPO,
                 Args const& args = Args::global())
@@ -1155,16 +1420,134 @@ template<typename T>
 using MPOPiece = map<QNProd,Mat<T>>;
 
 // SVD the coefficients matrix on each link and construct the compressed MPO matrix
+//
+//Computes the right singular vectors V (as columns)
+//and squared singular values D2 (in decreasing order) of
+//the block matrix M with sparse elements vm, without
+//forming M as a dense matrix. Diagonalizes whichever of
+//M^dag*M or M*M^dag is smaller; in the second case V is
+//recovered from the left singular vectors as M^dag*U/s.
+//
 template<typename T>
 void
+gramDecomp(vector<MatElem<T>> const& vm,
+           Mat<T> & V,
+           Vector & D2)
+    {
+    int nr = 0, nc = 0;
+    for(auto const& elem : vm)
+        {
+        nr = max(nr,1+elem.ind.row);
+        nc = max(nc,1+elem.ind.col);
+        }
+
+    //Group the elements sharing a row (if nc <= nr)
+    //or a column (otherwise), then accumulate the
+    //corresponding Gram matrix from each group
+    auto byrow = (nc <= nr);
+    auto ng = byrow ? nr : nc;
+    auto groups = vector<vector<pair<int,T>>>(ng);
+    for(auto const& elem : vm)
+        {
+        if(byrow) groups.at(elem.ind.row).emplace_back(elem.ind.col,elem.val);
+        else      groups.at(elem.ind.col).emplace_back(elem.ind.row,elem.val);
+        }
+    auto nG = byrow ? nc : nr;
+    auto G = Mat<T>(nG,nG);
+    for(auto const& g : groups)
+    for(auto const& a : g)
+    for(auto const& b : g)
+        {
+        //byrow: G = M^dag*M, otherwise G = M*M^dag
+        if(byrow) G(a.first,b.first) += conj(a.second)*b.second;
+        else      G(a.first,b.first) += a.second*conj(b.second);
+        }
+
+    Mat<T> U;
+    diagHermitian(G,U,D2);
+    for(auto& d : D2) d = max(d,0.);
+
+    if(byrow)
+        {
+        V = move(U);
+        return;
+        }
+
+    //Singular values this small are not resolved by G
+    auto null = vector<bool>(nG);
+    for(auto i : range(nG)) null[i] = (D2(i) <= 1E-14*D2(0));
+
+    //V(c,i) = sum_r conj(M(r,c)) U(r,i) / s_i
+    V = Mat<T>(nc,nG);
+    for(auto const& elem : vm)
+    for(auto i : range(nG))
+        {
+        if(null[i]) continue;
+        V(elem.ind.col,i) += conj(elem.val)*U(elem.ind.row,i)/std::sqrt(D2(i));
+        }
+
+    //Columns of null singular values (kept if Minm or a
+    //negative Cutoff asks for them) are orthonormalized
+    //unit vectors, so that V has orthonormal columns as
+    //when computed by an SVD
+    auto e = 0;
+    for(auto i : range(nG))
+        {
+        if(!null[i]) continue;
+        auto nrm = 0.;
+        while(nrm < 0.5)
+            {
+            if(e >= nc) Error("gramDecomp: could not complete the basis");
+            for(auto c : range(nc)) V(c,i) = (c == e ? 1 : 0);
+            ++e;
+            //Project out the other columns (twice, for stability)
+            for(int pass = 0; pass < 2; ++pass)
+            for(auto j : range(nG))
+                {
+                if(j == i) continue;
+                auto ov = T(0);
+                for(auto c : range(nc)) ov += conj(V(c,j))*V(c,i);
+                for(auto c : range(nc)) V(c,i) -= ov*V(c,j);
+                }
+            nrm = 0.;
+            for(auto c : range(nc)) nrm += std::norm(V(c,i));
+            nrm = std::sqrt(nrm);
+            }
+        for(auto c : range(nc)) V(c,i) /= nrm;
+        }
+    }
+
+//Sizes of the QN blocks of the links of an
+//existing MPO, to be reproduced by compressMPO
+//(used by MPOUpdater::update)
+struct KeepLinks
+    {
+    //blocks[n] lists the QN and size of each block of link n
+    vector<vector<pair<QN,long>>> blocks;
+    std::atomic<bool> ok;
+
+    KeepLinks() : ok(true) { }
+
+    //Size of block q of link n (-1 if none)
+    long
+    size(int n, QN const& q) const
+        {
+        for(auto& b : blocks.at(n)) if(b.first == q) return b.second;
+        return -1;
+        }
+    };
+
+template<typename T, typename MatEls>
+void
 compressMPO(SiteSet const& sites,
             vector<QNBlock<T>> const& qbs, 
-            vector<IQMatEls> const& tempMPO,
+            vector<MatEls> const& tempMPO,
             vector<MPOPiece<T>> & finalMPO, 
             vector<IQIndex> & links, 
             bool isExpH = false, 
             Complex tau = 0,
-            Args const& args = Args::global())
+            Args const& args = Args::global(),
+            KeepLinks* keep = nullptr)
     {
     const int N = sites.N();
     Real eps = 1E-14;
@@ -1172,6 +1555,11 @@ compressMPO(SiteSet const& sites,
     int minm = args.getInt("Minm",1);
     int maxm = args.getInt("Maxm",5000);
     Real cutoff = args.getReal("Cutoff",1E-13);
+    auto nthread = args.getInt("NThread",1);
+    auto verbose = args.getBool("Verbose",false);
+    auto method = args.getString("BlockDecomp","SVD");
+    if(method != "Gram" && method != "SVD") Error("BlockDecomp must be \"Gram\" or \"SVD\"");
+    auto use_svd = (method == "SVD");
     //printfln("Using cutoff = %.2E",cutoff);
     //printfln("Using minm = %d",minm);
     //printfln("Using maxm = %d",maxm);
@@ -1194,32 +1582,82 @@ compressMPO(SiteSet const& sites,
         //Put in factor of (-tau) if isExpH==true
         if(isExpH) Error("Need to put in factor of (-tau)");
 
+        auto site_time = cpu_time();
+
         auto V_npp = map<QN, Mat<T>>();
 
         int nsector = 1; //always have ZeroQN sector
 
+        //Make all entries of V_npp before decomposing
+        //the blocks, possibly on several threads
+        auto blocks = vector<vector<MatElem<T>> const*>();
+        auto Vs = vector<Mat<T>*>();
+        auto qns = vector<QN const*>();
         for(auto& qb : qbs.at(n-1) )
             {
             auto& qn = qb.first;
             if(qn != ZeroQN) ++nsector;
+            blocks.push_back(&qb.second.mat);
+            Vs.push_back(&V_npp[qn]);
+            qns.push_back(&qn);
+            }
 
-            // Convert the block matrix elements to a dense matrix
-            auto M = toMatrix(qb.second.mat);
-
-            auto& V = V_npp[qn];
-
-            Mat<T> U;
+        auto decompBlock = [&](size_t b)
+            {
+            auto& V = *Vs[b];
             Vector D;
-            SVD(M,U,D,V);
-
-            //square singular vals for call to truncate
-            for(auto& d : D) d = sqr(d);
+            if(use_svd)
+                {
+                // Convert the block matrix elements to a dense matrix
+                auto M = toMatrix(*blocks[b]);
+                Mat<T> U;
+                SVD(M,U,D,V);
+                //square singular vals for call to truncate
+                for(auto& d : D) d = sqr(d);
+                }
+            else
+                {
+                gramDecomp(*blocks[b],V,D);
+                }
+            if(keep)
+                {
+                //Keep the size of this block in the existing
+                //link, provided this discards little weight
+                auto& q = *qns[b];
+                auto m = keep->size(n,q);
+                if(m < 0) keep->ok = false;
+                if(q == ZeroQN) m -= d0;
+                m = max(m,0l);
+                Real total = 0,
+                     disc = 0;
+                for(auto i : range(D.size()))
+                    {
+                    total += D(i);
+                    if(long(i) >= m) disc += D(i);
+                    }
+                if(total > 0 && disc/total > cutoff) keep->ok = false;
+                auto Vm = Mat<T>(nrows(V),m);
+                for(auto r : range(nrows(V)))
+                for(auto c : range(min(long(ncols(V)),m)))
+                    {
+                    Vm(r,c) = V(r,c);
+                    }
+                V = move(Vm);
+                return;
+                }
             truncate(D,maxm,minm,cutoff);
             int m = D.size();
-
-            int nc = ncols(M);
-            resize(V,nc,m);
-            }
+            resize(V,nrows(V),m);
+            };
+
+        //Blocks are listed in QN order, not by size, so
+        //deal them out round-robin to balance the threads
+        auto nb = blocks.size();
+        auto nt = std::min(size_t(nthread > 1 ? nthread : 1),nb);
+        detail::parallelFor(nt,[&](size_t t)
+            {
+            for(auto b = t; b < nb; b += nt) decompBlock(b);
+            });
 
         int count = 0;
         auto inqn = stdx::reserve_vector<IndexQN>(nsector);
@@ -1233,6 +1671,22 @@ compressMPO(SiteSet const& sites,
             inqn.emplace_back(Index(format("hl%d_%d",n,count++),m),q);
             }
         links.at(n) = IQIndex(nameint("Hl",n),move(inqn));
+        if(keep && n < N)
+            {
+            //Check for the same blocks in the same order
+            auto& kb = keep->blocks.at(n);
+            auto& l = links.at(n);
+            if(long(kb.size()) != l.nindex()) keep->ok = false;
+            else
+                {
+                auto i = 0;
+                for(auto iq : l)
+                    {
+                    if(kb[i].first != iq.qn || kb[i].second != iq.m()) keep->ok = false;
+                    ++i;
+                    }
+                }
+            }
 
         //
         // Construct the compressed MPO
@@ -1314,6 +1768,12 @@ compressMPO(SiteSet const& sites,
         V_n = move(V_npp);
         
         max_d = max(max_d, links.at(n).m());
+
+        if(verbose)
+            {
+            printfln("compressMPO: site %d, %d QN blocks, link dim %d, %s",
+                     n,nb,links.at(n).m(),site_time.sincemark());
+            }
         }
     //println("Maximal dimension of the MPO is ", max_d);
     }
@@ -1524,6 +1984,262 @@ constructMPOTensors(SiteSet const& sites,
     return H;
     }
 
+//
+// Fit f(r), r = 1,...,L (f[0] unused), as
+//
+//   f(r) ~= c^T A^(r-1) b
+//
+// with A a KxK matrix, i.e. a sum of K exponentials
+// whose decay rates are the eigenvalues of A. Uses the
+// SVD of the Hankel matrix H(i,j) = f(i+j+1), whose rows
+// (columns) span c^T A^i (A^j b), with K increased until
+// the largest error is at most cutoff*max_r |f(r)|.
+// Returns the largest error of the fit.
+//
+Real
+fitExpSum(vector<Real> const& f,
+          Matrix & A,
+          Vector & b,
+          Vector & c,
+          Real cutoff,
+          int maxk)
+    {
+    A = Matrix();
+    b = Vector();
+    c = Vector();
+    auto L = int(f.size())-1;
+    auto fmax = 0.;
+    for(auto r : range1(L)) fmax = max(fmax,std::fabs(f[r]));
+    if(fmax == 0.) return 0.;
+
+    auto R = (L+2)/2,
+         C = L+1-R;
+    auto Hk = Matrix(R,C);
+    for(auto i : range(R))
+    for(auto j : range(C))
+        {
+        Hk(i,j) = f[1+i+j];
+        }
+    Matrix U,V;
+    Vector D;
+    SVD(Hk,U,D,V);
+    auto rank = 0;
+    for(auto& d : D) if(d > 1E-14*D(0)) ++rank;
+
+    auto err = 0.;
+    for(auto K : range1(min(rank,maxk)))
+        {
+        //Row i of O is c^T A^i
+        auto O = Matrix(R,K);
+        b = Vector(K);
+        c = Vector(K);
+        for(auto k : range(K))
+            {
+            auto sk = std::sqrt(D(k));
+            for(auto i : range(R)) O(i,k) = U(i,k)*sk;
+            c(k) = O(0,k);
+            b(k) = V(0,k)*sk;
+            }
+
+        //Solve the shift relation O(i+1,:) = O(i,:)*A
+        //by least squares, with the pseudo-inverse
+        //of the first R-1 rows of O
+        A = Matrix(K,K);
+        if(R > 1)
+            {
+            auto Ou = Matrix(R-1,K);
+            for(auto i : range(R-1))
+            for(auto k : range(K))
+                {
+                Ou(i,k) = O(i,k);
+                }
+            Matrix Uu,Vu;
+            Vector Du;
+            SVD(Ou,Uu,Du,Vu);
+            for(auto q : range(Du.size()))
+                {
+                if(Du(q) <= 1E-14*Du(0)) continue;
+                for(auto l : range(K))
+                    {
+                    auto x = 0.;
+                    for(auto i : range(R-1)) x += Uu(i,q)*O(i+1,l);
+                    x /= Du(q);
+                    for(auto k : range(K)) A(k,l) += Vu(k,q)*x;
+                    }
+                }
+            }
+
+        //Largest error of c^T A^(r-1) b
+        err = 0.;
+        auto v = b;
+        for(auto r : range1(L))
+            {
+            auto fr = 0.;
+            for(auto k : range(K)) fr += c(k)*v(k);
+            err = max(err,std::fabs(fr-f[r]));
+            auto Av = Vector(K);
+            for(auto k : range(K))
+            for(auto l : range(K))
+                {
+                Av(k) += A(k,l)*v(l);
+                }
+            v = move(Av);
+            }
+        if(err <= cutoff*fmax) break;
+        }
+    return err;
+    }
+
+//
+// Add the couplings added by AutoMPO::addLongRange to the
+// links and pieces made by constructFinalMPO. Coupling p,
+// fitted as c^T A^(r-1) b, occupies K new values of each link
+// (appended to the QN sector -div(op1)), which form a finite
+// state machine:
+//
+//   start on site n: IL (row 1) -> channel l: b_l op1
+//   pass site n:     channel k  -> channel l: A(l,k) Id (or F)
+//   end on site n:   channel k  -> HL (col 0): c_k op2
+//
+template<typename T>
+void
+addLongRangeChannels(SiteSet const& sites,
+                     vector<AutoMPO::LongRangeTerm> const& lr,
+                     vector<MPOPiece<T>> & finalMPO,
+                     vector<IQIndex> & links,
+                     Args const& args)
+    {
+    auto N = sites.N();
+    auto checkqn = args.getBool("CheckQN",true);
+    auto verbose = args.getBool("Verbose",false);
+    auto cutoff = args.getReal("LongRangeCutoff",1E-10);
+    auto maxk = args.getInt("LongRangeMaxm",50);
+    if(args.getBool("Infinite",false)) Error("Long-range couplings not supported for infinite MPO");
+
+    const QN ZeroQN;
+
+    struct Channels
+        {
+        Matrix A;
+        Vector b,
+               c;
+        QN q;
+        long offset = 0; //position within the new values of sector q
+        };
+    auto ch = vector<Channels>(lr.size());
+    auto extra = map<QN,long>();
+    for(auto p : range(lr.size()))
+        {
+        auto& t = lr[p];
+        auto& C = ch[p];
+        auto err = fitExpSum(t.V,C.A,C.b,C.c,cutoff,maxk);
+        if(checkqn)
+            {
+            C.q = -div(sites.op(t.op1,1));
+            for(auto n : range1(2,N))
+                {
+                if(-div(sites.op(t.op1,n)) != C.q)
+                    {
+                    Error(format("Long-range operator %s must have the same QN divergence on every site",t.op1));
+                    }
+                }
+            }
+        C.offset = extra[C.q];
+        extra[C.q] += C.b.size();
+        if(verbose)
+            {
+            printfln("Long-range %s-%s fit by %d exponentials, max error %.2E",t.op1,t.op2,C.b.size(),err);
+            }
+        }
+
+    //Enlarge the sectors of each internal link
+    auto olddim = vector<map<QN,long>>(N+1);
+    for(auto n : range1(N-1))
+        {
+        auto& l = links.at(n);
+        auto inqn = vector<IndexQN>();
+        for(auto iq : l)
+            {
+            olddim[n][iq.qn] = iq.m();
+            auto it = extra.find(iq.qn);
+            auto m = iq.m() + (it != extra.end() ? it->second : 0);
+            inqn.emplace_back(Index(iq.index.rawname(),m),iq.qn);
+            }
+        auto count = l.nindex();
+        for(auto& qe : extra)
+            {
+            if(olddim[n].count(qe.first) || qe.second == 0) continue;
+            inqn.emplace_back(Index(format("hl%d_%d",n,count++),qe.second),qe.first);
+            }
+        links.at(n) = IQIndex(l.rawname(),move(inqn));
+        }
+
+    auto dim = [&links](int n, QN const& q) { return findByQN(links.at(n),q).m(); };
+
+    //Pad the existing pieces to the new sector sizes
+    for(auto n : range1(N))
+    for(auto& qp_M : finalMPO.at(n-1))
+        {
+        auto& rq = qp_M.first.q;
+        auto cq = checkqn ? rq-div(computeProd<IQTensor>(sites,qp_M.first.prod)) : ZeroQN;
+        auto& M = qp_M.second;
+        auto nr = dim(n-1,rq),
+             nc = dim(n,cq);
+        if(long(nrows(M)) == nr && long(ncols(M)) == nc) continue;
+        auto P = Mat<T>(nr,nc);
+        for(auto r : range(nrows(M)))
+        for(auto c : range(ncols(M)))
+            {
+            P(r,c) = M(r,c);
+            }
+        M = move(P);
+        }
+
+    auto piece = [&](int n, QN const& rq, QN const& cq, SiteTermProd const& prod) -> Mat<T>&
+        {
+        auto& M = finalMPO.at(n-1)[QNProd{rq,prod}];
+        if(nrows(M) == 0) M = Mat<T>(dim(n-1,rq),dim(n,cq));
+        return M;
+        };
+
+    for(auto p : range(lr.size()))
+        {
+        auto& t = lr[p];
+        auto& C = ch[p];
+        auto K = long(C.b.size());
+        if(K == 0) continue;
+        auto off = [&](int n) { return olddim[n][C.q]+C.offset; };
+        auto fermionic = isFermionic(SiteTerm(t.op1,1));
+        for(auto n : range1(N))
+            {
+            if(n < N)
+                {
+                auto start = SiteTermProd{SiteTerm(t.op1,n)};
+                rewriteFermionic(start,false);
+                auto& M = piece(n,ZeroQN,C.q,start);
+                for(auto l : range(K)) M(1,off(n)+l) += C.b(l);
+                }
+            if(n > 1 && n < N)
+                {
+                auto pass = SiteTermProd{SiteTerm(fermionic ? "F" : "Id",n)};
+                auto& M = piece(n,C.q,C.q,pass);
+                for(auto k : range(K))
+                for(auto l : range(K))
+                    {
+                    M(off(n-1)+k,off(n)+l) += C.A(l,k);
+                    }
+                }
+            if(n > 1)
+                {
+                auto end = SiteTermProd{SiteTerm(t.op2,n)};
+                rewriteFermionic(end,fermionic);
+                auto& M = piece(n,C.q,ZeroQN,end);
+                for(auto k : range(K)) M(off(n-1)+k,0) += C.c(k);
+                }
+            }
+        }
+    }
+
 template<typename Tensor>
 MPOt<Tensor>
 svdMPO(AutoMPO const& am, 
@@ -1532,8 +2248,10 @@ svdMPO(AutoMPO const& am,
     bool isExpH = false;
     Cplx tau = 0.;
 
+    auto terms = am.sortedTerms();
+
     bool is_real = true;
-    for(auto& t : am.terms())
+    for(auto& t : terms)
         {
         if(t.coef.imag() != 0.0)
             {
@@ -1548,20 +2266,22 @@ svdMPO(AutoMPO const& am,
         {
         auto qbs = vector<QNBlock<Real>>();
         auto tempMPO = vector<IQMatEls>();
-        partitionHTerms(am.sites(),am.terms(),qbs,tempMPO,args);
+        partitionHTerms(am.sites(),terms,qbs,tempMPO,args);
         auto finalMPO = vector<MPOPiece<Real>>();
         auto links = vector<IQIndex>();
         constructFinalMPO(am.sites(),qbs,tempMPO,finalMPO,links,isExpH,tau,args);
+        if(!am.longRange().empty()) addLongRangeChannels(am.sites(),am.longRange(),finalMPO,links,args);
         H = constructMPOTensors<Tensor,Real>(am.sites(),finalMPO,links,args);
         }
     else
         {
         auto qbs = vector<QNBlock<Cplx>>();
         auto tempMPO = vector<IQMatEls>();
-        partitionHTerms(am.sites(),am.terms(),qbs,tempMPO,args);
+        partitionHTerms(am.sites(),terms,qbs,tempMPO,args);
         auto finalMPO = vector<MPOPiece<Cplx>>();
         auto links = vector<IQIndex>();
 		constructFinalMPO(am.sites(),qbs,tempMPO,finalMPO,links,isExpH,tau,args);
+        if(!am.longRange().empty()) addLongRangeChannels(am.sites(),am.longRange(),finalMPO,links,args);
         H = constructMPOTensors<Tensor,Cplx>(am.sites(),finalMPO,links,args);
         }
 
@@ -1581,12 +2301,267 @@ svdMPO(AutoMPO const& am,
     return H;
     }
 
+//Copy of am with the long-range couplings
+//added as separate two-site terms
+AutoMPO
+expandLongRange(AutoMPO const& am)
+    {
+    auto res = AutoMPO(am.sites());
+    for(auto& t : am.terms()) res.add(t);
+    auto N = am.sites().N();
+    for(auto& t : am.longRange())
+    for(auto i : range1(N))
+    for(auto j : range1(i+1,N))
+        {
+        if(t.V.at(j-i) != 0.) res += t.V.at(j-i),t.op1,i,t.op2,j;
+        }
+    return res;
+    }
+
+//Checks the "LongRange" argument, returning
+//true if long-range couplings are to be fit
+bool
+fitLongRange(AutoMPO const& am,
+             Args const& args)
+    {
+    if(am.longRange().empty()) return false;
+    auto mode = args.getString("LongRange","Fit");
+    if(mode != "Fit" && mode != "Terms") Error("LongRange must be \"Fit\" or \"Terms\"");
+    if(mode == "Fit" && args.getBool("Exact",false))
+        {
+        Error("Exact AutoMPO conversion requires \"LongRange\"=\"Terms\"");
+        }
+    return (mode == "Fit");
+    }
+
+//Two independent 64-bit hashes (FNV-1a and
+//a polynomial hash) of the strings added
+struct MPOHash
+    {
+    uint64_t h1 = 14695981039346656037ull,
+             h2 = 0;
+
+    void
+    add(string const& s)
+        {
+        for(unsigned char c : s) put(c);
+        //Separator, so that "ab","c" differs from "a","bc"
+        put(256);
+        }
+
+    bool
+    operator!=(MPOHash const& o) const { return h1 != o.h1 || h2 != o.h2; }
+
+    private:
+
+    void
+    put(unsigned v)
+        {
+        h1 = (h1^v)*1099511628211ull;
+        h2 = h2*1000003ull+v+1;
+        }
+    };
+
+//Hash of everything determining the MPO made by
+//toMPO: the terms, the SiteSet and the arguments
+template<typename Tensor>
+MPOHash
+mpoHash(AutoMPO const& am,
+        Args const& args)
+    {
+    auto h = MPOHash();
+    h.add(std::is_same<Tensor,IQTensor>::value ? "IQMPO" : "MPO");
+    h.add(format("%.17g %d %d %d %d %d %s %s %.17g %d",
+                 args.getReal("Cutoff",1E-13),
+                 args.getInt("Maxm",5000),
+                 args.getInt("Minm",1),
+                 args.getBool("Exact",false),
+                 args.getBool("CheckQN",true),
+                 args.getBool("IsExpH",false),
+                 args.getString("BlockDecomp","SVD"),
+                 args.getString("LongRange","Fit"),
+                 args.getReal("LongRangeCutoff",1E-10),
+                 args.getInt("LongRangeMaxm",50)));
+    auto const& sites = am.sites();
+    for(auto j : range1(sites.N()))
+        {
+        auto s = sites(j);
+        h.add(format("%s %d",s.rawname(),s.m()));
+        for(auto iq : s) h.add(format("%s %d",iq.qn,iq.m()));
+        }
+    auto terms = am.sortedTerms();
+    for(auto& t : terms)
+        {
+        h.add(format("%.17g %.17g",t.coef.real(),t.coef.imag()));
+        for(auto& st : t.ops) h.add(format("%s %d",st.op,st.i));
+        }
+    for(auto& t : am.longRange())
+        {
+        h.add(t.op1);
+        h.add(t.op2);
+        for(auto v : t.V) h.add(format("%.17g",v));
+        }
+
+    //Elements of the site operators making up the MPO,
+    //so that changing the definition of an operator
+    //(for example in a custom SiteSet) changes the hash
+    auto used = set<pair<int,string>>();
+    auto fermionic = false;
+    auto use = [&](string const& op, int i)
+        {
+        used.emplace(i,op);
+        if(isFermionic(SiteTerm(op,i))) fermionic = true;
+        };
+    for(auto& t : terms)
+    for(auto& st : t.ops)
+        {
+        use(st.op,st.i);
+        }
+    for(auto& t : am.longRange())
+    for(auto j : range1(sites.N()))
+        {
+        use(t.op1,j);
+        use(t.op2,j);
+        }
+    for(auto j : range1(sites.N()))
+        {
+        use("Id",j);
+        if(fermionic) use("F",j);
+        }
+    for(auto& u : used)
+        {
+        auto s = IQIndex(sites(u.first));
+        auto Op = sites.op(u.second,u.first);
+        for(auto a : range1(s.m()))
+        for(auto b : range1(s.m()))
+            {
+            auto z = Op.cplx(dag(s)(a),prime(s)(b));
+            h.add(format("%.17g %.17g",z.real(),z.imag()));
+            }
+        }
+    return h;
+    }
+
+//MPO of the site indices of sites with the tensors of
+//W, read from a cache file: its site indices are replaced
+//by those of sites (having the same QN blocks) and its
+//links by new ones, as toMPO makes for each MPO
+template<typename Tensor>
+MPOt<Tensor>
+relabelCached(MPOt<Tensor> const& W,
+              SiteSet const& sites)
+    {
+    using IndexT = typename Tensor::index_type;
+    auto N = sites.N();
+    auto links = vector<IndexT>(N+1),
+         newlinks = vector<IndexT>(N+1);
+    for(auto n : range1(N-1))
+        {
+        links[n] = commonIndex(W.A(n),W.A(n+1),Link);
+        newlinks[n] = sim(links[n]);
+        }
+    auto H = MPOt<Tensor>(sites);
+    for(auto j : range1(N))
+        {
+        auto from = vector<IndexT>(),
+             to = vector<IndexT>();
+        for(auto& I : W.A(j).inds())
+            {
+            auto J = IndexT();
+            if(I.type() == Site)
+                {
+                J = prime(IndexT(sites(j)),I.primeLevel());
+                }
+            else
+                {
+                for(auto n : {j-1,j}) if(links[n] && I == links[n]) J = newlinks[n];
+                if(!J) continue;
+                }
+            if(J.dir() != I.dir()) J.dag();
+            from.push_back(I);
+            to.push_back(J);
+            }
+        H.Aref(j) = relabelShared(W.A(j),from,to);
+        }
+    return H;
+    }
+
+//toMPO with "CacheDir" set: reads the MPO from the
+//cache file named by the hash of the AutoMPO if
+//present, otherwise converts it and writes the file
+template<typename Tensor>
+MPOt<Tensor>
+cachedMPO(AutoMPO const& am,
+          Args const& args)
+    {
+    auto verbose = args.getBool("Verbose",false);
+    auto h = mpoHash<Tensor>(am,args);
+    auto fname = format("%s/mpo_%016x.dat",args.getString("CacheDir"),h.h1);
+    auto const& sites = am.sites();
+    if(fileExists(fname))
+        {
+        std::ifstream f(fname.c_str(),std::ios::binary);
+        uint64_t h2 = 0;
+        itensor::read(f,h2);
+        if(f.good() && h2 == h.h2)
+            {
+            auto W = MPOt<Tensor>();
+            W.read(f);
+            if(f.good() && W.N() == sites.N())
+                {
+                if(verbose) printfln("Read MPO from cache file %s",fname);
+                return relabelCached(W,sites);
+                }
+            }
+        }
+
+    auto H = toMPO<Tensor>(am,{args,"CacheDir",""});
+
+    //Write to a temporary file of a unique name first, so
+    //that jobs (or threads) sharing the cache directory
+    //never read or write a partly written file
+    auto tmpname = vector<char>(fname.begin(),fname.end());
+    for(char c : string(".XXXXXX")) tmpname.push_back(c);
+    tmpname.push_back('\0');
+    //(failing to write it only costs later runs the
+    //conversion, so H is returned in any case)
+    auto fd = mkstemp(tmpname.data());
+    if(fd < 0)
+        {
+        printfln("Warning: couldn't create a temporary file for cache file %s",fname);
+        return H;
+        }
+    close(fd);
+    std::ofstream f(tmpname.data(),std::ios::binary);
+    itensor::write(f,h.h2);
+    H.write(f);
+    f.close();
+    if(f.fail() || std::rename(tmpname.data(),fname.c_str()) != 0)
+        {
+        std::remove(tmpname.data());
+        printfln("Warning: couldn't write cache file %s",fname);
+        return H;
+        }
+    if(verbose) printfln("Wrote MPO to cache file %s",fname);
+    return H;
+    }
+
 template<>
 IQMPO 
 toMPO(AutoMPO const& am, 
       Args const& args) 
     { 
     auto verbose = args.getBool("Verbose",false);
+    //The cache only holds the tensors of sites 1,...,N, not
+    //the boundary tensors of an infinite MPO
+    if(args.getString("CacheDir","") != "" && !args.getBool("Infinite",false))
+        {
+        return cachedMPO<IQTensor>(am,args);
+        }
+    if(!am.longRange().empty() && !fitLongRange(am,args))
+        {
+        return toMPO<IQTensor>(expandLongRange(am),args);
+        }
     if(args.getBool("Exact",false))
         {
         if(verbose) println("Using exact conversion of AutoMPO->IQMPO");
@@ -1601,6 +2576,14 @@ MPO
 toMPO(AutoMPO const& am, 
       Args const& args) 
     { 
+    if(args.getString("CacheDir","") != "" && !args.getBool("Infinite",false))
+        {
+        return cachedMPO<ITensor>(am,args);
+        }
+    if(!am.longRange().empty() && !fitLongRange(am,args))
+        {
+        return toMPO<ITensor>(expandLongRange(am),args);
+        }
     if(args.getBool("Exact",false))
         {
         println("Using exact conversion of AutoMPO->MPO");
@@ -1610,6 +2593,172 @@ toMPO(AutoMPO const& am,
     return svdMPO<ITensor>(am,{args,"CheckQN",false});
     }
 
+vector<pair<QN,long>>
+linkBlocks(Index const& l) { return {make_pair(QN(),l.m())}; }
+
+vector<pair<QN,long>>
+linkBlocks(IQIndex const& l)
+    {
+    auto res = vector<pair<QN,long>>();
+    for(auto iq : l) res.emplace_back(iq.qn,iq.m());
+    return res;
+    }
+
+namespace detail {
+
+//The partition of the terms of an AutoMPO made by
+//partitionHTerms, with each coefficient (of a block
+//element, or of a tempMPO element starting a term)
+//replaced by the number of its term
+struct TermPartition
+    {
+    MPOHash ops; //hash of the operators of the terms
+    vector<QNBlock<Real>> qbs;
+    vector<IQMatEls> tempMPO;
+    };
+
+} //namespace detail
+
+MPOHash
+opsHash(vector<HTerm> const& terms)
+    {
+    auto h = MPOHash();
+    for(auto& t : terms)
+        {
+        for(auto& st : t.ops)
+            {
+            h.add(st.op);
+            h.add(std::to_string(st.i));
+            }
+        h.add("");
+        }
+    return h;
+    }
+
+template<typename Tensor, typename T>
+MPOt<Tensor>
+refillMPO(SiteSet const& sites,
+          detail::TermPartition const& P,
+          vector<HTerm> const& terms,
+          Args const& args,
+          KeepLinks* keep)
+    {
+    auto coef = [&terms](Real t) { return terms.at(size_t(t)).coef; };
+    auto qbs = vector<QNBlock<T>>(P.qbs.size());
+    for(auto n : range(P.qbs.size()))
+    for(auto& qb : P.qbs[n])
+        {
+        auto& mat = qbs[n][qb.first].mat;
+        mat.reserve(qb.second.mat.size());
+        for(auto& el : qb.second.mat) mat.emplace_back(el.ind,forceType<T>(coef(el.val)));
+        }
+    auto tempMPO = vector<vector<IQMPOMatElem>>(P.tempMPO.size());
+    for(auto n : range(P.tempMPO.size()))
+        {
+        auto& tn = tempMPO[n];
+        tn.reserve(P.tempMPO[n].size());
+        for(auto& el : P.tempMPO[n])
+            {
+            tn.push_back(el);
+            if(el.row == -1) tn.back().val.coef = coef(el.val.coef.real());
+            }
+        }
+    auto finalMPO = vector<MPOPiece<T>>();
+    auto links = vector<IQIndex>();
+    compressMPO(sites,qbs,tempMPO,finalMPO,links,false,0,args,keep);
+    return constructMPOTensors<Tensor,T>(sites,finalMPO,links,args);
+    }
+
+template<typename Tensor>
+MPOt<Tensor>
+refillMPO(AutoMPO const& am,
+          detail::TermPartition const& P,
+          Args const& args,
+          KeepLinks* keep = nullptr)
+    {
+    auto terms = am.sortedTerms();
+    if(!am.longRange().empty() || long(P.qbs.size()) != am.sites().N() 
+       || opsHash(terms) != P.ops)
+        {
+        Error("MPOUpdater: terms differ from those of the AutoMPO it was made from");
+        }
+    for(auto& t : terms)
+        {
+        if(t.coef.imag() != 0.0) return refillMPO<Tensor,Cplx>(am.sites(),P,terms,args,keep);
+        }
+    return refillMPO<Tensor,Real>(am.sites(),P,terms,args,keep);
+    }
+
+template<typename Tensor>
+MPOUpdater<Tensor>::
+MPOUpdater(AutoMPO const& am,
+           Args const& args)
+  : args_(args)
+    {
+    args_.add("CacheDir","");
+    if(std::is_same<Tensor,ITensor>::value) args_.add("CheckQN",false);
+    if(!am.longRange().empty() || args_.getBool("Exact",false) 
+       || args_.getBool("Infinite",false)) 
+        {
+        return;
+        }
+    auto terms = am.sortedTerms();
+    auto P = std::make_shared<detail::TermPartition>();
+    P->ops = opsHash(terms);
+    for(auto t : range(terms.size())) terms[t].coef = Real(t);
+    partitionHTerms(am.sites(),terms,P->qbs,P->tempMPO,args_);
+    part_ = move(P);
+    }
+
+template<typename Tensor>
+MPOt<Tensor> MPOUpdater<Tensor>::
+mpo(AutoMPO const& am) const
+    {
+    if(!part_) return toMPO<Tensor>(am,args_);
+    return refillMPO<Tensor>(am,*part_,args_);
+    }
+
+template<typename Tensor>
+bool MPOUpdater<Tensor>::
+update(AutoMPO const& am,
+       MPOt<Tensor> & H) const
+    {
+    using IndexT = typename Tensor::index_type;
+    auto N = am.sites().N();
+    if(H.N() != N) Error("MPOUpdater: MPO and AutoMPO have different numbers of sites");
+
+    auto rebuild = [&]()
+        {
+        H = mpo(am);
+        return false;
+        };
+    if(!part_ || N < 2) return rebuild();
+
+    auto old = vector<IndexT>(N);
+    KeepLinks keep;
+    keep.blocks.resize(N+1);
+    for(auto n : range1(N-1))
+        {
+        old.at(n) = commonIndex(H.A(n),H.A(n+1),Link);
+        if(!old.at(n)) return rebuild();
+        keep.blocks.at(n) = linkBlocks(old.at(n));
+        }
+
+    auto W = refillMPO<Tensor>(am,*part_,args_,&keep);
+    if(!keep.ok) return rebuild();
+
+    for(auto n : range1(N-1))
+        {
+        auto l = commonIndex(W.A(n),W.A(n+1),Link);
+        W.Aref(n) *= delta(dag(l),old.at(n));
+        W.Aref(n+1) *= delta(l,dag(old.at(n)));
+        }
+    H = move(W);
+    return true;
+    }
+template class MPOUpdater<ITensor>;
+template class MPOUpdater<IQTensor>;
+
 //template<>
 //MPO
 //toMPO<ITensor>(const AutoMPO& a,
@@ -1630,6 +2779,9 @@ toExpH_ZW1(const AutoMPO& am,
     using IndexT = typename Tensor::index_type;
     auto checkqn = args.getBool("CheckQN",true);
 
+    //The ZW1 approximation is built from the individual terms
+    if(!am.longRange().empty()) return toExpH_ZW1<Tensor>(expandLongRange(am),tau,args);
+
     auto const& sites = am.sites();
     auto H = MPOt<Tensor>(sites);
     const int N = sites.N();
@@ -1848,6 +3000,56 @@ toExpH<ITensor>(const AutoMPO& a,
     return res;
     }
 
+LatticeGraph
+interactionGraph(AutoMPO const& a)
+    {
+    auto pairs = set<pair<int,int>>();
+    for(auto& t : a.terms())
+    for(auto& st1 : t.ops)
+    for(auto& st2 : t.ops)
+        {
+        if(st1.i < st2.i) pairs.emplace(st1.i,st2.i);
+        }
+    auto N = a.sites().N();
+    for(auto& t : a.longRange())
+    for(auto i : range1(N))
+    for(auto j : range1(i+1,N))
+        {
+        if(t.V.at(j-i) != 0.) pairs.emplace(i,j);
+        }
+    auto G = LatticeGraph();
+    G.reserve(pairs.size());
+    for(auto& p : pairs) G.emplace_back(p.first,p.second);
+    return G;
+    }
+
+AutoMPO
+reorder(AutoMPO const& a,
+        SitePermutation const& P)
+    {
+    auto const& sites = a.sites();
+    auto N = sites.N();
+    if(P.N() != N) Error("reorder: SitePermutation and AutoMPO have different numbers of sites");
+    for(auto i : range1(N))
+        {
+        if(sites(i).m() != sites(P.newSite(i)).m())
+            {
+            Error(format("reorder: sites %d and %d are of different types",i,P.newSite(i)));
+            }
+        }
+    auto res = AutoMPO(sites);
+    //HTerm::add keeps the operators in site order,
+    //accounting for fermionic signs
+    auto terms = a.longRange().empty() ? a.terms() : expandLongRange(a).terms();
+    for(auto& t : terms)
+        {
+        auto nt = HTerm(t.coef,SiteTermProd{});
+        for(auto& st : t.ops) nt.add(st.op,P.newSite(st.i));
+        res.add(nt);
+        }
+    return res;
+    }
+
 std::ostream& 
 operator<<(std::ostream& s, SiteTerm const& t)
     {
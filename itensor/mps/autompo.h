@@ -7,7 +7,12 @@
 
 #include "itensor/global.h"
 #include "itensor/mps/mpo.h"
+#include "itensor/mps/lattice/siteorder.h"
 #include <set>
+#include <map>
+#include <functional>
+#include <memory>
+#include <mutex>
 
 namespace itensor {
 
@@ -17,11 +22,81 @@ class AutoMPO;
 // Given an AutoMPO representing a Hamiltonian H,
 // returns an exact IQMPO form of H.
 //
+// Arguments recognized by the (default) compressed construction:
+// o "Cutoff", "Maxm", "Minm" - truncation of each QN block
+// o "BlockDecomp":
+//   - (Default) "SVD" - SVD of each QN block made dense
+//   - "Gram" - decompose each QN block by diagonalizing its Gram
+//     matrix, accumulated from the sparse block elements; faster
+//     for large, sparse blocks but resolves singular values only
+//     down to about 1E-8 of the largest
+// o "NThread" - number of threads decomposing the QN blocks of a site
+// o "Verbose" - print timing and link dimension of each site
+//
+// Arguments recognized for terms added by AutoMPO::addLongRange:
+// o "LongRange":
+//   - (Default) "Fit" - fit each coupling V(r) by a sum of
+//     exponentials, giving a finite-state-machine MPO whose
+//     bond dimension is independent of the number of sites
+//   - "Terms" - add every pair i<j as a separate term
+// o "LongRangeCutoff" - maximum error of the fit relative
+//   to max_r |V(r)| (default 1E-10)
+// o "LongRangeMaxm" - maximum number of exponentials per coupling
+//
+// o "CacheDir" - if set, look in this directory for an MPO
+//   previously made from the same terms, SiteSet and arguments
+//   (identified by a hash of these, including the elements of
+//   the site operators used), reading it instead of
+//   converting the AutoMPO again. Otherwise the new MPO is
+//   written to the directory for later runs. Ignored if
+//   "Infinite" is set.
+//
 template <typename Tensor>
 MPOt<Tensor>
 toMPO(AutoMPO const& a,
       Args const& args = Args::global());
 
+namespace detail { struct TermPartition; }
+
+//
+// Makes the MPOs of AutoMPOs having the same terms up to
+// their coefficients, such as those of a scan over the
+// couplings of a Hamiltonian. The constructor partitions
+// the terms among the links of the MPO, which is most of
+// the work of toMPO, so that mpo and update only need to
+// put in the coefficients and compress the MPO.
+//
+// AutoMPOs with long-range couplings (see addLongRange),
+// or converted with "Exact" or "Infinite" set, are
+// converted by toMPO each time.
+//
+template <typename Tensor>
+class MPOUpdater
+    {
+    Args args_;
+    std::shared_ptr<detail::TermPartition const> part_;
+    public:
+
+    MPOUpdater() { }
+
+    MPOUpdater(AutoMPO const& a,
+               Args const& args = Args::global());
+
+    //Same as toMPO<Tensor>(a,args); a must have the same
+    //terms as the AutoMPO given to the constructor, up
+    //to their coefficients
+    MPOt<Tensor>
+    mpo(AutoMPO const& a) const;
+
+    //Refills H, made from an AutoMPO with the same terms
+    //as a, with the terms of a while keeping the link
+    //indices of H (and so the sizes of its QN blocks).
+    //If the new coefficients need larger links than H
+    //has, replaces H by mpo(a) and returns false.
+    bool
+    update(AutoMPO const& a,
+           MPOt<Tensor> & H) const;
+    };
 
 //
 // Given an AutoMPO representing a Hamiltonian H,
@@ -141,9 +216,49 @@ class AutoMPO
     {
     public:
     using storage = std::set<HTerm,LessNoCoef>;
+
+    //Translation-invariant two-body coupling
+    //sum_{i<j} V[j-i] op1_i op2_j
+    struct LongRangeTerm
+        {
+        std::string op1,
+                    op2;
+        std::vector<Real> V; //V[r], r = 1,...,N-1 (V[0] unused)
+        };
     private:
+
+    //Terms added by addTerms, all having the same
+    //number of operators, stored as flat arrays.
+    //Row t has coefficient coef[t] and operators
+    //(site[t*nops+k],op[t*nops+k]) in site order.
+    //Rows are kept sorted and free of duplicates.
+    struct FlatTerms
+        {
+        std::vector<Cplx> coef;
+        std::vector<int> site,
+                         op;
+        };
+
+    //Guards the lazy moving of flat_ into terms_ by the
+    //const members, so that threads can share a const
+    //AutoMPO; copies get a mutex of their own
+    struct FlushMutex
+        {
+        std::mutex m;
+        FlushMutex() { }
+        FlushMutex(FlushMutex const&) { }
+        FlushMutex&
+        operator=(FlushMutex const&) { return *this; }
+        };
+
     SiteSet sites_;
-    storage terms_;
+    mutable storage terms_;
+    mutable std::map<int,FlatTerms> flat_;
+    mutable FlushMutex flushm_;
+    std::vector<LongRangeTerm> longrange_;
+    std::vector<std::string> opnames_;
+    std::vector<bool> opfermi_;
+    std::map<std::string,int> opids_;
 
     enum State { New, Op };
 
@@ -200,10 +315,17 @@ class AutoMPO
     sites() const { return sites_; }
 
     storage const&
-    terms() const { return terms_; }
+    terms() const { flush(); return terms_; }
+
+    //The terms in the order of terms(), but made by
+    //sorting the terms added by addTerms and merging
+    //them with the others, without moving them into
+    //the set of terms
+    std::vector<HTerm>
+    sortedTerms() const;
 
     int
-    size() const { return terms_.size(); }
+    size() const { flush(); return terms_.size(); }
 
     operator MPO() const { return toMPO<ITensor>(*this); }
 
@@ -216,10 +338,100 @@ class AutoMPO
     void
     add(HTerm const& t);
 
+    //
+    // Bulk ingestion of many terms, for example
+    // the O(N^4) terms of a quantum chemistry
+    // Hamiltonian. Term t is
+    //
+    //   coefs[t] * op(opids[t*nops]) on site sites[t*nops] 
+    //            * ... 
+    //            * op(opids[t*nops+nops-1]) on site sites[t*nops+nops-1]
+    //
+    // where operator ids are obtained from opId("name").
+    // The same reordering (and fermion signs) as for
+    // terms added with += are applied. Duplicate terms are
+    // merged by sorting the flat arrays (in parallel with
+    // "NThread" > 1 threads) rather than by inserting
+    // into the set of terms one at a time.
+    //
+    void
+    addTerms(int nops,
+             std::vector<Cplx> const& coefs,
+             std::vector<int> const& opids,
+             std::vector<int> const& sites,
+             Args const& args = Args::global());
+
+    void
+    addTerms(int nops,
+             std::vector<Real> const& coefs,
+             std::vector<int> const& opids,
+             std::vector<int> const& sites,
+             Args const& args = Args::global());
+
+    //
+    // Long-range coupling 
+    //
+    //   sum_{i<j} V(j-i) op1_i op2_j
+    //
+    // of a translation-invariant system, such as a
+    // power-law or Coulomb interaction. Rather than
+    // adding the O(N^2) pairs as separate terms,
+    // toMPO fits V(r) by a sum of exponentials so that
+    // the MPO bond dimension does not grow with N.
+    // For a Hermitian coupling such as S+_i S-_j, also
+    // add the conjugate pair (here S-_i S+_j).
+    //
+    void
+    addLongRange(std::string const& op1,
+                 std::string const& op2,
+                 std::function<Real(int)> const& V);
+
+    std::vector<LongRangeTerm> const&
+    longRange() const { return longrange_; }
+
+    //Integer id of the operator named opname
+    //(assigning a new id if needed)
+    int
+    opId(std::string const& opname);
+
+    std::string const&
+    opName(int id) const { return opnames_.at(id); }
+
     void
-    reset() { terms_.clear(); }
+    reset() { terms_.clear(); flat_.clear(); longrange_.clear(); }
+
+    private:
+
+    //Move terms from flat_ into terms_
+    void
+    flush() const;
+
+    //sortedTerms without locking flushm_
+    std::vector<HTerm>
+    mergeTerms() const;
     };
 
+//
+// Graph with a bond between each pair of sites
+// acted on by a common term of a (including the
+// long-range couplings), to be passed to siteOrdering
+// for Hamiltonians not defined on a lattice, such as
+// orbital (quantum chemistry) Hamiltonians.
+//
+LatticeGraph
+interactionGraph(AutoMPO const& a);
+
+//
+// Returns the terms of a with each site i relabeled
+// P.newSite(i), re-sorted into site order (with the
+// sign changes this implies for fermionic operators).
+// The SiteSet of a is kept, so site i and P.newSite(i)
+// must be of the same type.
+//
+AutoMPO
+reorder(AutoMPO const& a,
+        SitePermutation const& P);
+
 std::ostream& 
 operator<<(std::ostream& s, SiteTerm const& t);
 
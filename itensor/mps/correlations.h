@@ -0,0 +1,186 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_CORRELATIONS_H
+#define __ITENSOR_CORRELATIONS_H
+
+#include <array>
+#include "itensor/mps/mps.h"
+#include "itensor/util/threadpool.h"
+
+namespace itensor {
+
+//
+// Correlation matrix C(i-1,j-1) = <psi|A_i B_j|psi>/<psi|psi>
+// for all pairs of sites i,j = 1,...,N of psi, where A and B
+// are the names of site operators (as passed to SiteSet::op,
+// such as "Sz" or "Cdag").
+//
+// All entries are computed in one pass: the contractions
+// of psi with itself to the left of each site are made once
+// and shared, and each row i extends them to the right of
+// site i, so the cost is O(N^2) site contractions rather
+// than O(N^3) from computing each entry separately.
+//
+// Arguments recognized:
+// o "Fermionic" (default: false) - A and B are fermionic
+//   operators: insert the Jordan-Wigner string operator
+//   between sites i and j (and on the leftmost of them)
+//   and include the sign from reordering A_i B_j if i > j
+// o "String" (default: "F") - name of the Jordan-Wigner
+//   string operator
+// o "NThread" (default: 1) - number of threads computing
+//   rows of the matrix in parallel
+//
+template<typename MPSType>
+CMatrix
+correlationMatrix(MPSType const& psi,
+                  std::string const& A,
+                  std::string const& B,
+                  Args const& args = Args::global());
+
+//
+// Correlation matrices for several pairs of operators
+// ops[n] = {A,B}, sharing the contractions of psi among them
+//
+template<typename MPSType>
+std::vector<CMatrix>
+correlationMatrices(MPSType psi,
+                    std::vector<std::pair<std::string,std::string>> const& ops,
+                    Args const& args = Args::global());
+
+
+
+namespace detail {
+
+//Contract X (the sites left of j, null if j == 1) with
+//site j of psi, the operator O, and the conjugate of site j
+//with its left link and site index primed. If close is false,
+//the right link of the conjugate is also primed so the
+//result can be extended to site j+1; otherwise the right
+//link is traced over, giving a scalar.
+template<typename MPSType, typename Tensor>
+Tensor
+correlationStep(MPSType const& psi,
+                int j,
+                Tensor const& X,
+                Tensor const& O,
+                bool close)
+    {
+    auto& Aj = psi.A(j);
+    auto R = X ? X*Aj : Aj;
+    if(O) R *= O;
+    auto Ad = O ? prime(Aj,Site) : Aj;
+    if(!close) Ad.prime(Link);
+    else if(j > 1) Ad.prime(commonIndex(Aj,psi.A(j-1),Link));
+    R *= dag(Ad);
+    return R;
+    }
+
+} //namespace detail
+
+template<typename MPSType>
+std::vector<CMatrix>
+correlationMatrices(MPSType psi,
+                    std::vector<std::pair<std::string,std::string>> const& ops,
+                    Args const& args)
+    {
+    using Tensor = typename MPSType::TensorT;
+    auto fermionic = args.getBool("Fermionic",false);
+    auto strop = args.getString("String","F");
+    auto nthread = args.getInt("NThread",1);
+    if(nthread < 1) Error("NThread must be set >= 1");
+
+    auto N = psi.N();
+    auto const& sites = psi.sites();
+    auto sign = fermionic ? -1. : 1.;
+    auto nop = ops.size();
+
+    psi.position(1);
+    auto nrm2 = sqr(norm(psi.A(1)));
+
+    //Site operators: lop[n][i][0] (lop[n][i][1]) is A (B) times
+    //the string operator if fermionic, for the left end of a
+    //pair at i; rop[n][i][0] (rop[n][i][1]) is A (B) for the right end
+    auto op = [&sites](std::string const& name, int i) { return Tensor(sites.op(name,i)); };
+    auto lop = std::vector<std::vector<std::array<Tensor,2>>>(nop,std::vector<std::array<Tensor,2>>(N+1)),
+         rop = lop;
+    auto dop = std::vector<std::vector<Tensor>>(nop,std::vector<Tensor>(N+1));
+    auto F = std::vector<Tensor>(N+1);
+    for(auto i : range1(N))
+        {
+        if(fermionic) F[i] = op(strop,i);
+        for(auto n : range(nop))
+            {
+            auto& a = ops[n].first;
+            auto& b = ops[n].second;
+            lop[n][i][0] = fermionic ? op(a+"*"+strop,i) : op(a,i);
+            lop[n][i][1] = fermionic ? op(b+"*"+strop,i) : op(b,i);
+            rop[n][i][0] = op(a,i);
+            rop[n][i][1] = op(b,i);
+            dop[n][i] = op(a+"*"+b,i);
+            }
+        }
+
+    //L[i] is sites 1,...,i of psi contracted with dag(psi)
+    auto L = std::vector<Tensor>(N+1);
+    for(auto i : range1(N-1))
+        {
+        L[i] = detail::correlationStep(psi,i,L[i-1],Tensor(),false);
+        }
+
+    auto res = std::vector<CMatrix>(nop,CMatrix(N,N));
+
+    auto doRow = [&](int i)
+        {
+        for(auto n : range(nop))
+            {
+            auto& C = res[n];
+            auto same = (ops[n].first == ops[n].second);
+            C(i-1,i-1) = detail::correlationStep(psi,i,L[i-1],dop[n][i],true).cplx()/nrm2;
+            if(i == N) continue;
+            //X[0] starts with A at i and fills row i,
+            //X[1] starts with B at i and fills column i
+            auto X = std::array<Tensor,2>{};
+            for(auto k : range(same ? 1 : 2))
+                {
+                X[k] = detail::correlationStep(psi,i,L[i-1],lop[n][i][k],false);
+                }
+            for(auto j : range1(i+1,N))
+                {
+                C(i-1,j-1) = detail::correlationStep(psi,j,X[0],rop[n][j][1],true).cplx()/nrm2;
+                if(same) C(j-1,i-1) = sign*C(i-1,j-1);
+                else     C(j-1,i-1) = sign*detail::correlationStep(psi,j,X[1],rop[n][j][0],true).cplx()/nrm2;
+                if(j == N) break;
+                for(auto k : range(same ? 1 : 2))
+                    {
+                    X[k] = detail::correlationStep(psi,j,X[k],F[j],false);
+                    }
+                }
+            }
+        };
+
+    //Row i takes time ~ N-i, so deal rows out cyclically
+    nthread = std::min(nthread,long(N));
+    detail::parallelFor(nthread,[&](size_t t)
+        {
+        for(auto i = 1+int(t); i <= N; i += nthread) doRow(i);
+        });
+
+    return res;
+    }
+
+template<typename MPSType>
+CMatrix
+correlationMatrix(MPSType const& psi,
+                  std::string const& A,
+                  std::string const& B,
+                  Args const& args)
+    {
+    return correlationMatrices(psi,{{A,B}},args).front();
+    }
+
+} //namespace itensor
+
+#endif
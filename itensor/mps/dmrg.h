@@ -8,6 +8,7 @@
 #include "itensor/eigensolver.h"
 #include "itensor/mps/localmposet.h"
 #include "itensor/mps/localmpo_mps.h"
+#include "itensor/mps/localsparsempo.h"
 #include "itensor/mps/sweeps.h"
 #include "itensor/mps/DMRGObserver.h"
 #include "itensor/util/cputime.h"
@@ -86,6 +87,37 @@ dmrg(MPSt<Tensor>& psi,
     return energy;
     }
 
+//
+//DMRG with a sparse (operator-valued matrix) MPO
+//
+template <class Tensor>
+Real
+dmrg(MPSt<Tensor>& psi, 
+     SparseMPOt<Tensor> const& H, 
+     Sweeps const& sweeps,
+     Args const& args = Global::args())
+    {
+    LocalSparseMPO<Tensor> PH(H,args);
+    Real energy = DMRGWorker(psi,PH,sweeps,args);
+    return energy;
+    }
+
+//
+//DMRG with a sparse MPO and a custom DMRGObserver
+//
+template <class Tensor>
+Real
+dmrg(MPSt<Tensor>& psi, 
+     SparseMPOt<Tensor> const& H, 
+     Sweeps const& sweeps, 
+     DMRGObserver<Tensor>& obs,
+     Args const& args = Global::args())
+    {
+    LocalSparseMPO<Tensor> PH(H,args);
+    Real energy = DMRGWorker(psi,PH,sweeps,obs,args);
+    return energy;
+    }
+
 //
 //DMRG with a set of MPOs (lazily summed)
 //(H vector is 0-indexed)
@@ -169,6 +201,64 @@ dmrg(MPSt<Tensor>& psi,
 
 
 
+//
+// One-site update with subspace expansion
+//
+// Replaces the MPS tensor at site j by phi, then moves the
+// orthogonality center to site j+1 (dir==Fromleft) or
+// site j-1 (dir==Fromright).
+//
+// If the "Noise" arg is > 0, the basis of the bond being crossed
+// is enlarged using the single-site ("DMRG3S") subspace expansion
+// of Hubig et al., PRB 91, 155115 (2015): the reduced density matrix
+// of phi is perturbed by Noise*P*dag(P), where P is the
+// projected operator PH applied to phi with the environment on the
+// side opposite to dir left open. New basis states enter the 
+// neighboring site tensor with zero weight so the state is unchanged 
+// up to truncation, but the bond dimension can grow.
+//
+template <class Tensor, class LocalOpT>
+Spectrum
+expandOneSite(MPSt<Tensor>& psi,
+              int j,
+              Tensor const& phi,
+              Direction dir,
+              LocalOpT const& PH,
+              Args const& args = Args::global())
+    {
+    auto k = (dir==Fromleft ? j+1 : j-1);
+    auto b = std::min(j,k);
+
+    auto A = psi.A(b);
+    auto B = psi.A(b+1);
+    auto spec = denmatDecomp(phi,A,B,dir,PH,args);
+
+    //denmatDecomp only leaves the center matrix on the
+    //side of the new orthogonality center, so multiply
+    //it into the neighboring site tensor
+    if(dir == Fromleft) 
+        {
+        psi.setA(j,A);
+        psi.Aref(k) = B*psi.A(k);
+        }
+    else
+        {
+        psi.setA(j,B);
+        psi.Aref(k) = A*psi.A(k);
+        }
+
+    if(args.getBool("DoNormalize",false))
+        {
+        auto nrm = itensor::norm(psi.A(k));
+        if(nrm > 1E-16) psi.Aref(k) *= 1./nrm;
+        }
+
+    psi.leftLim(k-1);
+    psi.rightLim(k+1);
+
+    return spec;
+    }
+
 //
 // DMRGWorker
 //
@@ -207,6 +297,9 @@ DMRGWorker(MPSt<Tensor>& psi,
     for(int sw = 1; sw <= sweeps.nsweep(); ++sw)
         {
         cpu_time sw_time;
+        auto nc = sweeps.numCenter(sw);
+        if(nc != 1 && nc != 2) Error("DMRG: numCenter must be 1 or 2");
+        if(PH.numCenter() != nc) PH.numCenter(nc);
         args.add("Sweep",sw);
         args.add("NSweep",sweeps.nsweep());
         args.add("Cutoff",sweeps.cutoff(sw));
@@ -236,13 +329,32 @@ DMRGWorker(MPSt<Tensor>& psi,
                 printfln("Sweep=%d, HS=%d, Bond=%d/%d",sw,ha,b,(N-1));
                 }
 
-            PH.position(b,psi);
+            Spectrum spec;
+            if(nc == 1)
+                {
+                //Optimize site b moving right and
+                //site b+1 moving left, so that
+                //bond b is truncated in either case
+                auto j = (ha==1 ? b : b+1);
+
+                PH.position(j,psi);
+
+                auto phi = psi.A(j);
 
-            auto phi = psi.A(b)*psi.A(b+1);
+                energy = davidson(PH,phi,args);
 
-            energy = davidson(PH,phi,args);
-            
-            auto spec = psi.svdBond(b,phi,(ha==1?Fromleft:Fromright),PH,args);
+                spec = expandOneSite(psi,j,phi,(ha==1?Fromleft:Fromright),PH,args);
+                }
+            else
+                {
+                PH.position(b,psi);
+
+                auto phi = psi.A(b)*psi.A(b+1);
+
+                energy = davidson(PH,phi,args);
+                
+                spec = psi.svdBond(b,phi,(ha==1?Fromleft:Fromright),PH,args);
+                }
 
 
             if(!quiet)
@@ -0,0 +1,294 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_GATECIRCUIT_H
+#define __ITENSOR_GATECIRCUIT_H
+
+#include "itensor/mps/bondgate.h"
+#include "itensor/mps/sharedtensors.h"
+
+namespace itensor {
+
+//
+// Makes real- or imaginary-time BondGates, computing the
+// exponential only once for each distinct bond Hamiltonian:
+// a gate whose bondH equals (up to relabeling its site indices)
+// the bondH of an earlier gate with the same type and tau is
+// made by relabeling that gate's tensor, sharing its storage.
+//
+// For example, for a uniform chain
+//
+//   auto cache = BondGateCache<IQTensor>(sites);
+//   for(int b = 1; b < N; ++b)
+//       {
+//       gates.push_back(cache.gate(b,b+1,IQGate::tReal,tstep/2.,hh(b)));
+//       }
+//
+// computes a single exponential.
+//
+template <class Tensor>
+class BondGateCache
+    {
+    public:
+    using IndexT = typename Tensor::index_type;
+    using GateT = BondGate<Tensor>;
+    using Type = typename GateT::Type;
+
+    BondGateCache(SiteSet const& sites) : sites_(sites) { }
+
+    //Same as BondGate<Tensor>(sites,i1,i2,type,tau,bondH)
+    GateT
+    gate(int i1,
+         int i2,
+         Type type,
+         Real tau,
+         Tensor const& bondH);
+
+    //Number of exponentials computed so far
+    int
+    size() const { return int(cache_.size()); }
+
+    private:
+
+    struct Entry
+        {
+        Type type;
+        Real tau;
+        int i1,i2;
+        Tensor bondH;
+        Tensor gate;
+        };
+
+    SiteSet sites_;
+    std::vector<Entry> cache_;
+
+    //Relabel the site indices of T from those
+    //of sites (i1,i2) to those of sites (j1,j2);
+    //returns a null tensor if their shapes differ
+    Tensor
+    relabelSites(Tensor const& T, int i1, int i2, int j1, int j2) const;
+    };
+
+//
+// Compiles a list of BondGates (as passed to gateTEvol)
+// into an equivalent list, meant to be computed once and
+// reused for every time step:
+//
+// o Each gate is fused with the previous gate acting on
+//   exactly the same pair of sites if no gate in between acts
+//   on either site, since the gates in between commute with
+//   it. Only gates on the identical pair of sites are fused:
+//   a gate on sites (i,i+1) between Swap gates on sites
+//   (i+1,i+2), as used for further-neighbor interactions,
+//   spans three sites and is left unchanged.
+// o Fused gates equal to the identity (such as two Swap gates
+//   in a row) are removed.
+// o The gates are reordered, keeping the order of any two gates
+//   acting on a common site, so that each gate acts as close as
+//   possible to the previous one. This reduces the number of
+//   times gateTEvol moves the orthogonality center of the MPS.
+//
+// Fused gates have type BondGate::Custom.
+//
+// Arguments recognized:
+// o "Fuse" (default: true) - fuse gates
+// o "Reorder" (default: true) - reorder gates
+// o "Verbose" (default: false) - print the number of gates
+//   before and after compiling
+//
+template <class Iterable>
+std::vector<typename Iterable::value_type>
+compileGates(SiteSet const& sites,
+             Iterable const& gatelist,
+             Args const& args = Args::global());
+
+
+
+template <class Tensor>
+Tensor BondGateCache<Tensor>::
+relabelSites(Tensor const& T, int i1, int i2, int j1, int j2) const
+    {
+    auto from = std::vector<IndexT>{},
+         to = std::vector<IndexT>{};
+    for(auto& I : T.inds())
+        {
+        auto s = noprime(I);
+        if(s != IndexT(sites_(i1)) && s != IndexT(sites_(i2))) return Tensor();
+        auto J = prime(IndexT(sites_(s == IndexT(sites_(i1)) ? j1 : j2)),I.primeLevel());
+        if(J.dir() != I.dir()) J.dag();
+        if(!detail::sameShape(I,J)) return Tensor();
+        from.push_back(I);
+        to.push_back(J);
+        }
+    return relabelShared(T,from,to);
+    }
+
+template <class Tensor>
+BondGate<Tensor> BondGateCache<Tensor>::
+gate(int i1,
+     int i2,
+     Type type,
+     Real tau,
+     Tensor const& bondH)
+    {
+    for(auto& e : cache_)
+        {
+        if(e.type != type || e.tau != tau) continue;
+        auto H = relabelSites(e.bondH,e.i1,e.i2,i1,i2);
+        if(!H || norm(H-bondH) > 1E-14*norm(bondH)) continue;
+        return GateT(sites_,i1,i2,relabelSites(e.gate,e.i1,e.i2,i1,i2));
+        }
+    auto g = GateT(sites_,i1,i2,type,tau,bondH);
+    cache_.push_back(Entry{type,tau,i1,i2,bondH,g.gate()});
+    return g;
+    }
+
+namespace detail {
+
+//Gate applying G1, then G2, to the same sites
+template <class Tensor>
+Tensor
+fuseGates(Tensor const& G1, Tensor const& G2)
+    {
+    auto G = prime(G2,Site);
+    G *= G1;
+    G.mapprime(2,1,Site);
+    return G;
+    }
+
+//Number of sites the orthogonality center moves
+//between gates on sites (a1,a2) and (b1,b2)
+int inline
+gaugeMoves(int a1, int a2, int b1, int b2)
+    {
+    if(b1 >= a2) return b1-a2;
+    if(b2 <= a1) return a1-b2;
+    return 0;
+    }
+
+} //namespace detail
+
+template <class Iterable>
+std::vector<typename Iterable::value_type>
+compileGates(SiteSet const& sites,
+             Iterable const& gatelist,
+             Args const& args)
+    {
+    using GateT = typename Iterable::value_type;
+    auto fuse = args.getBool("Fuse",true);
+    auto reorder = args.getBool("Reorder",true);
+    auto verbose = args.getBool("Verbose",false);
+
+    auto lo = [](GateT const& g) { return std::min(g.i1(),g.i2()); };
+    auto hi = [](GateT const& g) { return std::max(g.i1(),g.i2()); };
+
+    //Fuse each gate into the last gate acting on its
+    //sites, if that gate acts on exactly the same sites
+    auto gates = std::vector<GateT>{};
+    auto fused = std::vector<bool>{};
+    auto last = std::vector<int>(sites.N()+1,-1);
+    auto ngate = 0;
+    for(auto& g : gatelist)
+        {
+        ++ngate;
+        auto p = last.at(lo(g));
+        if(fuse && p >= 0 && p == last.at(hi(g))
+           && lo(gates[p]) == lo(g) && hi(gates[p]) == hi(g))
+            {
+            auto G = detail::fuseGates(gates[p].gate(),g.gate());
+            gates[p] = GateT(sites,gates[p].i1(),gates[p].i2(),G);
+            fused[p] = true;
+            continue;
+            }
+        last.at(lo(g)) = last.at(hi(g)) = int(gates.size());
+        gates.push_back(g);
+        fused.push_back(false);
+        }
+
+    //Remove fused gates equal to the identity
+    auto keep = std::vector<bool>(gates.size(),true);
+    for(auto n : range(gates.size()))
+        {
+        if(!fused[n]) continue;
+        auto& g = gates[n];
+        auto Id = sites.op("Id",g.i1())*sites.op("Id",g.i2());
+        auto G = g.gate();
+        if(norm(G-Id) < 1E-14*norm(Id)) keep[n] = false;
+        }
+
+    //Gate n may be applied once all gates before
+    //it acting on a common site have been applied
+    auto deps = std::vector<std::vector<int>>(gates.size());
+    auto users = std::vector<std::vector<int>>(gates.size());
+    std::fill(last.begin(),last.end(),-1);
+    for(auto n : range(gates.size()))
+        {
+        if(!keep[n]) continue;
+        for(auto i : {lo(gates[n]),hi(gates[n])})
+            {
+            auto p = last.at(i);
+            if(p >= 0 && (deps[n].empty() || deps[n].back() != p))
+                {
+                deps[n].push_back(p);
+                users[p].push_back(n);
+                }
+            last.at(i) = n;
+            }
+        }
+
+    auto res = std::vector<GateT>{};
+    res.reserve(gates.size());
+    if(!reorder)
+        {
+        for(auto n : range(gates.size())) if(keep[n]) res.push_back(gates[n]);
+        }
+    else
+        {
+        //Greedily apply the ready gate closest to the
+        //previous one, favoring the original order in ties
+        auto nwait = std::vector<size_t>(gates.size());
+        auto ready = std::vector<int>{};
+        for(auto n : range(gates.size()))
+            {
+            nwait[n] = deps[n].size();
+            if(keep[n] && nwait[n] == 0) ready.push_back(n);
+            }
+        auto prev = -1;
+        while(!ready.empty())
+            {
+            auto best = ready.begin();
+            if(prev >= 0)
+                {
+                auto cost = [&](int n)
+                    {
+                    return detail::gaugeMoves(lo(gates[prev]),hi(gates[prev]),lo(gates[n]),hi(gates[n]));
+                    };
+                for(auto it = ready.begin(); it != ready.end(); ++it)
+                    {
+                    auto c = cost(*it),
+                         cb = cost(*best);
+                    if(c < cb || (c == cb && *it < *best)) best = it;
+                    }
+                }
+            else
+                {
+                best = std::min_element(ready.begin(),ready.end());
+                }
+            prev = *best;
+            ready.erase(best);
+            res.push_back(gates[prev]);
+            for(auto u : users[prev]) if(--nwait[u] == 0) ready.push_back(u);
+            }
+        }
+
+    if(verbose)
+        {
+        printfln("compileGates: %d gates compiled to %d gates",ngate,res.size());
+        }
+    return res;
+    }
+
+} //namespace itensor
+
+#endif
@@ -0,0 +1,322 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_LATTICE_SITEORDER_H_
+#define __ITENSOR_LATTICE_SITEORDER_H_
+
+#include <algorithm>
+#include "itensor/mps/lattice/latticebond.h"
+#include "itensor/tensor/algs.h"
+
+namespace itensor {
+
+//
+// Relabeling of sites 1,...,N: original site i
+// is placed at position newSite(i) of the MPS,
+// and position j holds original site oldSite(j).
+//
+// For example, to measure a site operator after
+// running DMRG with a reordered Hamiltonian:
+//
+//   auto P = siteOrdering(lattice,N);
+//   auto H = IQMPO(reorder(ampo,P));
+//   ...
+//   for(auto i : range1(N))
+//       {
+//       auto j = P.newSite(i);
+//       //measure on psi.A(j) to get the value for site i
+//       }
+//
+class SitePermutation
+    {
+    std::vector<int> new_, //new_[i] = position of original site i
+                     old_; //old_[j] = original site at position j
+    public:
+
+    SitePermutation() { }
+
+    //Identity permutation
+    explicit
+    SitePermutation(int N);
+
+    //order[k] is the original site placed at position k+1
+    explicit
+    SitePermutation(std::vector<int> const& order);
+
+    int
+    N() const { return int(new_.size())-1; }
+
+    int
+    newSite(int i) const { return new_.at(i); }
+
+    int
+    oldSite(int j) const { return old_.at(j); }
+
+    SitePermutation
+    inverse() const;
+    };
+
+inline SitePermutation::
+SitePermutation(int N)
+  : new_(N+1),
+    old_(N+1)
+    {
+    for(auto i : range1(N)) new_[i] = old_[i] = i;
+    }
+
+inline SitePermutation::
+SitePermutation(std::vector<int> const& order)
+  : new_(order.size()+1,0),
+    old_(order.size()+1,0)
+    {
+    auto N = int(order.size());
+    for(auto k : range(N))
+        {
+        auto i = order[k];
+        if(i < 1 || i > N || new_[i] != 0) Error("SitePermutation: order must contain each site 1,...,N once");
+        new_[i] = k+1;
+        old_[k+1] = i;
+        }
+    }
+
+inline SitePermutation SitePermutation::
+inverse() const
+    {
+    auto order = std::vector<int>(N());
+    for(auto i : range1(N())) order[i-1] = new_[i];
+    return SitePermutation(order);
+    }
+
+//Bonds of G with each site i relabeled P.newSite(i)
+//(site coordinates and bond types are unchanged)
+LatticeGraph inline
+reorder(LatticeGraph G,
+        SitePermutation const& P)
+    {
+    for(auto& b : G)
+        {
+        b.s1 = P.newSite(b.s1);
+        b.s2 = P.newSite(b.s2);
+        }
+    return G;
+    }
+
+//Largest distance |P(s1)-P(s2)| between the ends of a bond
+int inline
+bandwidth(LatticeGraph const& G,
+          SitePermutation const& P)
+    {
+    auto w = 0;
+    for(auto& b : G) w = std::max(w,std::abs(P.newSite(b.s1)-P.newSite(b.s2)));
+    return w;
+    }
+
+//Largest number of bonds crossing any cut between
+//positions j and j+1. For a Hamiltonian of two-site
+//terms on the bonds of G, the MPO bond dimension at
+//the cut grows with this number.
+int inline
+maxCut(LatticeGraph const& G,
+       SitePermutation const& P)
+    {
+    auto N = P.N();
+    auto ncross = std::vector<int>(N+1,0);
+    for(auto& b : G)
+        {
+        auto j1 = P.newSite(b.s1),
+             j2 = P.newSite(b.s2);
+        if(j1 > j2) std::swap(j1,j2);
+        ncross.at(j1) += 1;
+        ncross.at(j2) -= 1;
+        }
+    auto c = 0,
+         res = 0;
+    for(auto j : range1(N))
+        {
+        c += ncross[j];
+        res = std::max(res,c);
+        }
+    return res;
+    }
+
+namespace detail {
+
+//Sorted, duplicate-free neighbor lists of sites 1,...,N
+std::vector<std::vector<int>> inline
+neighbors(LatticeGraph const& G, int N)
+    {
+    auto nb = std::vector<std::vector<int>>(N+1);
+    for(auto& b : G)
+        {
+        if(b.s1 == b.s2) continue;
+        nb.at(b.s1).push_back(b.s2);
+        nb.at(b.s2).push_back(b.s1);
+        }
+    for(auto& n : nb)
+        {
+        std::sort(n.begin(),n.end());
+        n.erase(std::unique(n.begin(),n.end()),n.end());
+        }
+    return nb;
+    }
+
+//Breadth-first search from site s over unvisited sites,
+//visiting the neighbors of each site in order of increasing
+//degree. Appends the sites reached to order, sets last_level
+//to the position in order where the last level starts and
+//returns the number of levels.
+int inline
+bfsLevels(std::vector<std::vector<int>> const& nb,
+          int s,
+          std::vector<bool> & visited,
+          std::vector<int> & order,
+          size_t & last_level)
+    {
+    auto nlevel = 1;
+    last_level = order.size();
+    order.push_back(s);
+    visited[s] = true;
+    auto level_end = order.size();
+    for(auto q = last_level; q < order.size(); ++q)
+        {
+        if(q == level_end)
+            {
+            ++nlevel;
+            last_level = q;
+            level_end = order.size();
+            }
+        auto next = std::vector<int>{};
+        for(auto t : nb[order[q]]) if(!visited[t]) next.push_back(t);
+        std::stable_sort(next.begin(),next.end(),
+                         [&nb](int a, int b) { return nb[a].size() < nb[b].size(); });
+        for(auto t : next)
+            {
+            visited[t] = true;
+            order.push_back(t);
+            }
+        }
+    return nlevel;
+    }
+
+} //namespace detail
+
+//
+// Reverse Cuthill-McKee ordering of the sites of G:
+// each connected component is ordered breadth-first
+// from a pseudo-peripheral site, then the order is
+// reversed, which keeps the bandwidth small.
+//
+SitePermutation inline
+cuthillMcKee(LatticeGraph const& G,
+             int N)
+    {
+    auto nb = detail::neighbors(G,N);
+    auto order = std::vector<int>{};
+    order.reserve(N);
+    auto done = std::vector<bool>(N+1,false);
+    size_t last = 0;
+    for(auto s0 : range1(N))
+        {
+        if(done[s0]) continue;
+        //Start from the lowest degree site of this component
+        auto comp = std::vector<int>{};
+        auto seen = done;
+        detail::bfsLevels(nb,s0,seen,comp,last);
+        auto s = s0;
+        for(auto t : comp) if(nb[t].size() < nb[s].size()) s = t;
+        //Move to the lowest degree site of the last level
+        //while doing so increases the number of levels
+        auto nlevel = 0;
+        while(true)
+            {
+            auto trial = std::vector<int>{};
+            seen = done;
+            auto levels = detail::bfsLevels(nb,s,seen,trial,last);
+            if(levels <= nlevel) break;
+            nlevel = levels;
+            auto next = trial[last];
+            for(auto q = last; q < trial.size(); ++q)
+                {
+                if(nb[trial[q]].size() < nb[next].size()) next = trial[q];
+                }
+            s = next;
+            }
+        detail::bfsLevels(nb,s,done,order,last);
+        }
+    std::reverse(order.begin(),order.end());
+    return SitePermutation(order);
+    }
+
+//
+// Spectral ordering: sites sorted by their component
+// in the Fiedler vector (eigenvector of the second
+// smallest eigenvalue of the graph Laplacian).
+// Uses a dense eigensolver, so is meant for
+// up to a few thousand sites.
+//
+SitePermutation inline
+fiedlerOrder(LatticeGraph const& G,
+             int N)
+    {
+    auto nb = detail::neighbors(G,N);
+    auto L = Matrix(N,N);
+    for(auto i : range1(N))
+        {
+        L(i-1,i-1) = nb[i].size();
+        for(auto j : nb[i]) L(i-1,j-1) = -1;
+        }
+    Matrix U;
+    Vector d;
+    diagHermitian(L,U,d);
+    //Eigenvalues are in decreasing order
+    auto order = std::vector<int>(N);
+    for(auto i : range(N)) order[i] = i+1;
+    if(N > 1)
+        {
+        auto f = N-2;
+        std::stable_sort(order.begin(),order.end(),
+                         [&U,f](int a, int b) { return U(a-1,f) < U(b-1,f); });
+        }
+    return SitePermutation(order);
+    }
+
+//
+// Site ordering for the bonds of G among sites 1,...,N,
+// meant to reduce the bond dimension of an MPO
+// (and hence of the MPS) of a Hamiltonian on G.
+//
+// Arguments recognized:
+// o "Method":
+//   - (Default) "Best" - whichever of the orderings below
+//     (or the original one) has the smallest maxCut
+//   - "CuthillMcKee" - reverse Cuthill-McKee
+//   - "Fiedler" - spectral ordering
+//
+SitePermutation inline
+siteOrdering(LatticeGraph const& G,
+             int N,
+             Args const& args = Args::global())
+    {
+    auto method = args.getString("Method","Best");
+    if(method == "CuthillMcKee") return cuthillMcKee(G,N);
+    if(method == "Fiedler") return fiedlerOrder(G,N);
+    if(method != "Best") Error(format("Unknown site ordering Method=\"%s\"",method));
+
+    auto best = SitePermutation(N);
+    auto cut = maxCut(G,best);
+    for(auto P : {cuthillMcKee(G,N),fiedlerOrder(G,N)})
+        {
+        auto c = maxCut(G,P);
+        if(c < cut)
+            {
+            best = P;
+            cut = c;
+            }
+        }
+    return best;
+    }
+
+} //namespace itensor
+
+#endif
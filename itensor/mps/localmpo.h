@@ -6,6 +6,7 @@
 #define __ITENSOR_LOCALMPO
 #include "itensor/mps/mpo.h"
 #include "itensor/mps/localop.h"
+#include "itensor/util/threadpool.h"
 #include "itensor/util/print_macro.h"
 
 namespace itensor {
@@ -31,6 +32,135 @@ namespace itensor {
 //  This results in an unprojected region of
 //  num_center sites starting at site j.
 //
+//  If the named argument "NThread" is greater
+//  than 1, H|phi> and the edge tensor updates
+//  are split into independent terms over ranges
+//  of the MPO link index to the left (or right)
+//  of the center sites (QN blocks of this link
+//  for IQTensors), evaluated in parallel and summed.
+//  The threads come from a pool (see threadpool.h) and
+//  are reused, but each product still costs a few thread
+//  handoffs and competes with any BLAS threads for cores,
+//  so this pays off only when the products are large.
+//
+
+namespace detail {
+
+template<class Tensor>
+Tensor
+sumParts(std::vector<Tensor> parts)
+    {
+    auto res = Tensor();
+    for(auto& P : parts)
+        {
+        if(!P) continue;
+        if(!res) res = std::move(P);
+        else     res += P;
+        }
+    return res;
+    }
+
+//Sizes of the QN sectors of a link index
+//(a single sector for an Index)
+inline std::vector<std::pair<QN,long>>
+linkSectors(Index const& h) { return {{QN(),h.m()}}; }
+
+inline std::vector<std::pair<QN,long>>
+linkSectors(IQIndex const& h)
+    {
+    auto res = std::vector<std::pair<QN,long>>{};
+    for(auto n : range1(h.nindex())) res.emplace_back(h.qn(n),h.index(n).m());
+    return res;
+    }
+
+inline Index
+linkPiece(Index const& h, std::vector<std::pair<QN,long>> const& secs)
+    {
+    long m = 0;
+    for(auto& s : secs) m += s.second;
+    return Index(h.rawname(),m,h.type());
+    }
+
+inline IQIndex
+linkPiece(IQIndex const& h, std::vector<std::pair<QN,long>> const& secs)
+    {
+    auto iq = IQIndex::storage{};
+    for(auto& s : secs) iq.emplace_back(Index(h.rawname(),s.second,h.type()),s.first);
+    return IQIndex(h.rawname(),std::move(iq),h.dir());
+    }
+
+//Split the link index h into at most n ranges
+//of roughly equal size, not splitting QN sectors
+//unless there are fewer sectors than ranges.
+//Returns tensors S_k with indices dag(h) and a new
+//index of the size of range k, such that the
+//S_k*dag(S_k) sum to the identity on h.
+template<typename IndexT>
+std::vector<ITensorT<IndexT>>
+linkSlicers(IndexT const& h, int n)
+    {
+    auto secs = linkSectors(h);
+    if(long(secs.size()) < n)
+        {
+        //Cut sectors into smaller ranges
+        auto cut = std::vector<std::pair<QN,long>>{};
+        auto target = std::max(1l,h.m()/n);
+        for(auto& s : secs)
+            {
+            for(long done = 0; done < s.second; done += target)
+                {
+                cut.emplace_back(s.first,std::min(target,s.second-done));
+                }
+            }
+        secs.swap(cut);
+        }
+    //Group consecutive sectors into n ranges
+    auto groups = std::vector<std::vector<std::pair<QN,long>>>(1);
+    long size = 0;
+    for(auto& s : secs)
+        {
+        if(size > 0 && long(groups.size()) < n && size+s.second/2 > h.m()/n)
+            {
+            groups.emplace_back();
+            size = 0;
+            }
+        groups.back().push_back(s);
+        size += s.second;
+        }
+
+    auto S = std::vector<ITensorT<IndexT>>(groups.size());
+    long off = 0;
+    for(auto k : range(groups.size()))
+        {
+        auto hk = linkPiece(h,groups[k]);
+        S[k] = ITensorT<IndexT>(dag(h),hk);
+        for(auto i : range1(hk.m())) S[k].set(dag(h)(off+i),hk(i),1.);
+        off += hk.m();
+        }
+    return S;
+    }
+
+//Edge tensor update E*A*W*dag(A') computed as
+//a sum over ranges of the MPO link shared by E and W
+template<class Tensor>
+Tensor
+parallelEdge(Tensor const& E,
+             Tensor const& A,
+             Tensor const& W,
+             int nthread)
+    {
+    auto S = linkSlicers(commonIndex(E,W,Link),nthread);
+    auto parts = std::vector<Tensor>(S.size());
+    parallelFor(S.size(),[&](size_t k)
+        {
+        parts[k] = (E*S[k])*A;
+        parts[k] *= W*dag(S[k]);
+        parts[k] *= dag(prime(A));
+        });
+    return sumParts(std::move(parts));
+    }
+
+} //namespace detail
 
 template <class Tensor>
 class LocalMPO
@@ -112,6 +242,8 @@ class LocalMPO
     // to adjust the edge tensors such
     // that the MPO tensors at positions
     // b and b+1 are exposed
+    // (only the MPO tensor at b if 
+    //  numCenter() == 1)
     //
     template <class MPSType>
     void
@@ -172,6 +304,15 @@ class LocalMPO
         nc_ = val; 
         }
 
+    int
+    nthread() const { return nthread_; }
+    void
+    nthread(int val) 
+        { 
+        if(val < 1) Error("NThread must be set >= 1");
+        nthread_ = val; 
+        }
+
     long
     size() const { return lop_.size(); }
 
@@ -209,9 +350,16 @@ class LocalMPO
     std::vector<Tensor> PH_;
     int LHlim_,RHlim_;
     int nc_;
+    int nthread_;
 
     LocalOp<Tensor> lop_;
 
+    //Pieces of lop_ for parallel product,
+    //one per range of the left MPO link
+    std::vector<Tensor> Lk_,
+                        Opk_;
+    std::vector<LocalOp<Tensor>> lopk_;
+
     bool do_write_;
     std::string writedir_;
 
@@ -252,6 +400,7 @@ LocalMPO()
       LHlim_(-1),
       RHlim_(-1),
       nc_(2),
+      nthread_(1),
       do_write_(false),
       writedir_("."),
       Psi_(0)
@@ -266,12 +415,15 @@ LocalMPO(const MPOt<Tensor>& H,
       LHlim_(0),
       RHlim_(H.N()+1),
       nc_(2),
+      nthread_(1),
       do_write_(false),
       writedir_("."),
       Psi_(0)
     { 
     if(args.defined("NumCenter"))
         numCenter(args.getInt("NumCenter"));
+    if(args.defined("NThread"))
+        nthread(args.getInt("NThread"));
     }
 
 template <class Tensor>
@@ -283,12 +435,15 @@ LocalMPO(const MPSt<Tensor>& Psi,
       LHlim_(0),
       RHlim_(Psi.N()+1),
       nc_(2),
+      nthread_(1),
       do_write_(false),
       writedir_("."),
       Psi_(&Psi)
     { 
     if(args.defined("NumCenter"))
         numCenter(args.getInt("NumCenter"));
+    if(args.defined("NThread"))
+        nthread(args.getInt("NThread"));
     }
 
 template <class Tensor>
@@ -301,6 +456,7 @@ LocalMPO(const MPOt<Tensor>& H,
       LHlim_(0),
       RHlim_(H.N()+1),
       nc_(2),
+      nthread_(1),
       do_write_(false),
       writedir_("."),
       Psi_(0)
@@ -311,6 +467,8 @@ LocalMPO(const MPOt<Tensor>& H,
         lop_.update(Op_->A(1),Op_->A(2),L(),R());
     if(args.defined("NumCenter"))
         numCenter(args.getInt("NumCenter"));
+    if(args.defined("NThread"))
+        nthread(args.getInt("NThread"));
     }
 
 template <class Tensor>
@@ -324,6 +482,7 @@ LocalMPO(const MPSt<Tensor>& Psi,
       LHlim_(0),
       RHlim_(Psi.N()+1),
       nc_(2),
+      nthread_(1),
       do_write_(false),
       writedir_("."),
       Psi_(&Psi)
@@ -332,6 +491,8 @@ LocalMPO(const MPSt<Tensor>& Psi,
     PH_[Psi.N()+1] = RP;
     if(args.defined("NumCenter"))
         numCenter(args.getInt("NumCenter"));
+    if(args.defined("NThread"))
+        nthread(args.getInt("NThread"));
     }
 
 template <class Tensor>
@@ -347,6 +508,7 @@ LocalMPO(MPOt<Tensor> const& H,
       LHlim_(LHlim),
       RHlim_(RHlim),
       nc_(2),
+      nthread_(1),
       do_write_(false),
       writedir_("."),
       Psi_(0)
@@ -355,6 +517,7 @@ LocalMPO(MPOt<Tensor> const& H,
     PH_.at(RHlim) = RH;
     if(H.N()==2) lop_.update(Op_->A(1),Op_->A(2),L(),R());
     if(args.defined("NumCenter")) numCenter(args.getInt("NumCenter"));
+    if(args.defined("NThread")) nthread(args.getInt("NThread"));
     }
 
 template <class Tensor> inline
@@ -363,15 +526,32 @@ product(const Tensor& phi, Tensor& phip) const
     {
     if(Op_ != 0)
         {
-        lop_.product(phi,phip);
+        if(lopk_.size() > 1)
+            {
+            auto parts = std::vector<Tensor>(lopk_.size());
+            detail::parallelFor(parts.size(),[&](size_t k)
+                { lopk_[k].product(phi,parts[k]); });
+            phip = detail::sumParts(std::move(parts));
+            }
+        else
+            {
+            lop_.product(phi,phip);
+            }
         }
     else 
     if(Psi_ != 0)
         {
         int b = position();
         auto othr = (!L() ? dag(prime(Psi_->A(b),Link)) : L()*dag(prime(Psi_->A(b),Link)));
-        auto othrR = (!R() ? dag(prime(Psi_->A(b+1),Link)) : R()*dag(prime(Psi_->A(b+1),Link)));
-        othr *= othrR;
+        if(nc_ == 2)
+            {
+            auto othrR = (!R() ? dag(prime(Psi_->A(b+1),Link)) : R()*dag(prime(Psi_->A(b+1),Link)));
+            othr *= othrR;
+            }
+        else if(R())
+            {
+            othr *= R();
+            }
         auto z = (othr*phi).cplx();
 
         phip = dag(othr);
@@ -413,15 +593,32 @@ position(int b, const MPSType& psi)
     setRHlim(b+nc_); //not redundant since RHlim_ could be < b+nc_
 
 #ifdef DEBUG
-    if(nc_ != 2)
+    if(nc_ > 2)
         {
-        Error("LocalOp only supports 2 center sites currently");
+        Error("LocalOp only supports 1 or 2 center sites currently");
         }
 #endif
 
     if(Op_ != 0) //normal MPO case
         {
-        lop_.update(Op_->A(b),Op_->A(b+1),L(),R());
+        if(nc_ == 1) lop_.update(Op_->A(b),L(),R());
+        else         lop_.update(Op_->A(b),Op_->A(b+1),L(),R());
+
+        lopk_.clear();
+        if(nthread_ > 1 && L())
+            {
+            auto S = detail::linkSlicers(commonIndex(L(),Op_->A(b),Link),nthread_);
+            Lk_.resize(S.size());
+            Opk_.resize(S.size());
+            lopk_.resize(S.size());
+            for(auto k : range(S.size()))
+                {
+                Lk_[k] = L()*S[k];
+                Opk_[k] = Op_->A(b)*dag(S[k]);
+                if(nc_ == 1) lopk_[k].update(Opk_[k],Lk_[k],R());
+                else         lopk_[k].update(Opk_[k],Op_->A(b+1),Lk_[k],R());
+                }
+            }
         }
     }
 
@@ -464,6 +661,7 @@ shift(int j, Direction dir, const Tensor& A)
         setLHlim(j);
         setRHlim(j+nc_+1);
 
+        lopk_.clear();
         lop_.update(Op_->A(j+1),Op_->A(j+2),L(),R());
         }
     else //dir == Fromright
@@ -481,6 +679,7 @@ shift(int j, Direction dir, const Tensor& A)
         setLHlim(j-nc_-1);
         setRHlim(j);
 
+        lopk_.clear();
         lop_.update(Op_->A(j-1),Op_->A(j),L(),R());
         }
     }
@@ -507,6 +706,12 @@ makeL(const MPSType& psi, int k)
             while(LHlim_ < k)
                 {
                 auto ll = LHlim_;
+                if(nthread_ > 1 && PH_.at(ll))
+                    {
+                    PH_.at(ll+1) = detail::parallelEdge(PH_.at(ll),psi.A(ll+1),Op_->A(ll+1),nthread_);
+                    setLHlim(ll+1);
+                    continue;
+                    }
                 if(PH_.at(ll))
                     {
                     PH_.at(ll+1) = PH_.at(ll)*psi.A(ll+1);
@@ -549,6 +754,12 @@ makeR(const MPSType& psi, int k)
                 //Print(PH_.at(rl));
                 //Print(Op_->A(rl-1));
                 //Print(psi.A(rl-1));
+                if(nthread_ > 1 && PH_.at(rl))
+                    {
+                    PH_.at(rl-1) = detail::parallelEdge(PH_.at(rl),psi.A(rl-1),Op_->A(rl-1),nthread_);
+                    setRHlim(rl-1);
+                    continue;
+                    }
                 if(PH_.at(rl))
                     {
                     PH_.at(rl-1) = PH_.at(rl)*psi.A(rl-1);
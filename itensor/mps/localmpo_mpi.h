@@ -0,0 +1,505 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_LOCALMPO_MPI
+#define __ITENSOR_LOCALMPO_MPI
+
+#include "itensor/util/parallel.h"
+#include "itensor/mps/dmrg.h"
+
+namespace itensor {
+
+//
+// LocalMPO_MPI projects an MPO into the reduced Hilbert
+// space of one or two sites of an MPS, like LocalMPO, with
+// its edge tensors distributed over the nodes of env.
+//
+// The edge tensor of sites 1,...,j (or j,...,N) is split
+// into ranges of its MPO link index (QN blocks of the link
+// for IQTensors, see detail::linkSlicers), and each node
+// stores only its own range, so the memory of the edge
+// tensors is divided by the number of nodes. H|phi> and the
+// edge tensor updates are computed by each node from its
+// ranges; the partial results are summed and split into the
+// ranges of the next link so that each node receives only its
+// own range (reduceScatter), and only H|phi> itself is summed
+// onto every node (allReduce).
+//
+// The MPS and the Davidson vectors are not distributed:
+// every node runs the same DMRG sweep on its own copy of psi,
+// and must start from the same psi and H (same indices).
+// The "Noise" argument of DMRG is not supported, and the
+// edge tensors are not written to disk.
+//
+template <class Tensor>
+class LocalMPO_MPI
+    {
+    Environment const* env_ = nullptr;
+    MPOt<Tensor> const* Op_ = nullptr;
+    //PH_[j] is this node's range of the edge tensor including
+    //site j (null if it holds none), and S_[j] is the tensor
+    //selecting that range of the MPO link of the edge tensor
+    std::vector<Tensor> PH_,
+                        S_;
+    //LS_[j] (RS_[j]) are the tensors selecting the ranges of
+    //the MPO link of the left (right) edge tensor including
+    //site j; they are made on node 0 so that their indices are
+    //the same on every node
+    std::vector<std::vector<Tensor>> LS_,
+                                     RS_;
+    int LHlim_ = -1,
+        RHlim_ = -1,
+        nc_ = 2;
+    long size_ = -1;
+    //Zero tensors with the layouts of the ranges of the right
+    //MPO link scattered in product, and of its result, made by
+    //its first call after position() so that later calls only
+    //need to sum the data
+    mutable std::vector<Tensor> ZS_;
+    mutable Tensor ZR_;
+
+    public:
+
+    LocalMPO_MPI() { }
+
+    LocalMPO_MPI(Environment const& env,
+                 MPOt<Tensor> const& H,
+                 Args const& args = Args::global());
+
+    void
+    product(Tensor const& phi, Tensor & phip) const;
+
+    Tensor
+    deltaRho(Tensor const& AA,
+             Tensor const& comb,
+             Direction dir) const
+        {
+        Error("LocalMPO_MPI does not support Noise");
+        return Tensor();
+        }
+
+    //Adjust the edge tensors, using the MPS psi,
+    //such that the MPO tensors at positions b
+    //(and b+1 if numCenter() == 2) are exposed
+    template <class MPSType>
+    void
+    position(int b, MPSType const& psi);
+
+    int
+    position() const;
+
+    long
+    size() const { return size_; }
+
+    int
+    numCenter() const { return nc_; }
+    void
+    numCenter(int val)
+        {
+        if(val != 1 && val != 2) Error("LocalMPO_MPI: numCenter must be 1 or 2");
+        nc_ = val;
+        }
+
+    bool
+    doWrite() const { return false; }
+    void
+    doWrite(bool val)
+        {
+        if(val) Error("LocalMPO_MPI does not support writing to disk");
+        }
+
+    explicit operator bool() const { return Op_ != nullptr; }
+
+    private:
+
+    //Store this node's range of the edge tensor at j, given the
+    //node's part of it; the parts of all nodes are summed unless
+    //each node already holds the complete edge tensor
+    void
+    distribute(int j,
+               Tensor part,
+               std::vector<Tensor> const& S,
+               bool complete);
+
+    //Part of the edge tensor including site j from this node's
+    //range of the edge tensor E (at j-1 or j+1) with slicer S
+    Tensor
+    edgePart(int j, Tensor const& E, Tensor const& S, Tensor const& A) const;
+
+    template <class MPSType>
+    void
+    makeL(MPSType const& psi, int k);
+
+    template <class MPSType>
+    void
+    makeR(MPSType const& psi, int k);
+
+    //Sum the part T of a product over the nodes, given the
+    //zero tensor Z with its layout (made if null); the sum is
+    //complex if cplx or Z is complex
+    void
+    sumOverNodes(Tensor & T, Tensor & Z, bool cplx) const;
+
+    //Sum the parts v[k] of a product over the nodes, returning
+    //on node k the sum of the v[k], given the zero tensors Z with
+    //their layouts (made if empty)
+    Tensor
+    scatterOverNodes(std::vector<Tensor> & v, std::vector<Tensor> & Z, bool cplx) const;
+    };
+
+//
+//DMRG with an MPO whose edge tensors are distributed
+//over the nodes of env (see LocalMPO_MPI). The tensors
+//of psi and H are taken from node 0, so psi must have the
+//same SiteSet on every node; on return every node holds
+//the optimized psi. During the sweeps the random number
+//generators and the generator of Index ids use the same
+//seed on every node. Only node 0 prints output.
+//
+template <class Tensor>
+Real
+dmrg(Environment const& env,
+     MPSt<Tensor>& psi,
+     MPOt<Tensor> H,
+     Sweeps const& sweeps,
+     Args args = Args::global());
+
+
+
+namespace detail {
+
+//Replace the tensors of the MPS or MPO psi by
+//those of psi on node 0, along with its orthogonality
+//limits (leftLim and rightLim)
+template <class MPSType>
+void
+broadcastTensors(Environment const& env, MPSType& psi)
+    {
+    using Tensor = typename MPSType::TensorT;
+    auto A = std::vector<Tensor>{};
+    auto ll = psi.leftLim(),
+         rl = psi.rightLim();
+    if(env.firstNode()) for(auto j : range1(psi.N())) A.push_back(psi.A(j));
+    broadcast(env,A,ll,rl);
+    if(env.firstNode()) return;
+    if(long(A.size()) != psi.N()) Error("broadcastTensors: N must be the same on every node");
+    for(auto j : range1(psi.N())) psi.Aref(j) = std::move(A[j-1]);
+    psi.leftLim(ll);
+    psi.rightLim(rl);
+    }
+
+} //namespace detail
+
+template <class Tensor>
+LocalMPO_MPI<Tensor>::
+LocalMPO_MPI(Environment const& env,
+             MPOt<Tensor> const& H,
+             Args const& args)
+    : env_(&env),
+      Op_(&H),
+      PH_(H.N()+2),
+      S_(H.N()+2),
+      LS_(H.N()+2),
+      RS_(H.N()+2),
+      LHlim_(0),
+      RHlim_(H.N()+1)
+    {
+    if(args.defined("NumCenter")) numCenter(args.getInt("NumCenter"));
+    auto N = H.N();
+    for(auto j : range1(N-1))
+        {
+        if(env.firstNode())
+            {
+            LS_[j] = detail::linkSlicers(commonIndex(H.A(j),H.A(j+1),Link),env.nnodes());
+            RS_[j+1] = detail::linkSlicers(commonIndex(H.A(j+1),H.A(j),Link),env.nnodes());
+            }
+        broadcast(env,LS_[j],RS_[j+1]);
+        }
+    }
+
+template <class Tensor>
+void LocalMPO_MPI<Tensor>::
+product(Tensor const& phi, Tensor & phip) const
+    {
+    auto b = position();
+    auto N = Op_->N();
+    auto cplx = isComplex(phi);
+    auto& W1 = Op_->A(b);
+    auto WR = (nc_ == 2) ? Op_->A(b+1) : Tensor();
+
+    //This node's part of the sum over the left MPO link
+    //(the complete sum at the left end)
+    Tensor X;
+    if(LHlim_ == 0)
+        {
+        X = phi*W1;
+        }
+    else
+        {
+        auto& S = S_.at(LHlim_);
+        if(S) X = (PH_.at(LHlim_)*phi)*(W1*dag(S));
+        }
+
+    if(RHlim_ == N+1)
+        {
+        phip = (X && WR) ? X*WR : X;
+        if(LHlim_ != 0) sumOverNodes(phip,ZR_,cplx);
+        phip.mapprime(1,0);
+        return;
+        }
+
+    //Range S of the right MPO link of X
+    auto slice = [&X,&WR](Tensor const& S) { return WR ? X*(WR*dag(S)) : X*dag(S); };
+
+    //Sum the parts of X over the nodes only within the range of
+    //the right MPO link of each node, sending each node its range
+    auto& SR = S_.at(RHlim_);
+    Tensor Y;
+    if(LHlim_ == 0)
+        {
+        if(SR) Y = slice(SR);
+        }
+    else
+        {
+        auto& RS = RS_.at(RHlim_);
+        auto v = std::vector<Tensor>(env_->nnodes());
+        if(X) for(auto k : range(RS.size())) v[k] = slice(RS[k]);
+        X = Tensor();
+        Y = scatterOverNodes(v,ZS_,cplx);
+        }
+
+    phip = Tensor();
+    if(SR && Y) phip = Y*PH_.at(RHlim_);
+    sumOverNodes(phip,ZR_,cplx);
+    phip.mapprime(1,0);
+    }
+
+template <class Tensor>
+template <class MPSType>
+void LocalMPO_MPI<Tensor>::
+position(int b, MPSType const& psi)
+    {
+    if(!(*this)) Error("LocalMPO_MPI is null");
+    auto N = Op_->N();
+    makeL(psi,b-1);
+    makeR(psi,b+nc_);
+    LHlim_ = b-1;
+    RHlim_ = b+nc_;
+    ZS_.clear();
+    ZR_ = Tensor();
+
+    auto e = b+nc_-1;
+    size_ = 1;
+    if(b > 1) size_ *= commonIndex(psi.A(b-1),psi.A(b),Link).m();
+    if(e < N) size_ *= commonIndex(psi.A(e),psi.A(e+1),Link).m();
+    for(auto j : range1(b,e)) size_ *= findtype(Op_->A(j),Site).m();
+    }
+
+template <class Tensor>
+int LocalMPO_MPI<Tensor>::
+position() const
+    {
+    if(RHlim_-LHlim_ != (nc_+1)) throw ITError("LocalMPO_MPI position not set");
+    return LHlim_+1;
+    }
+
+template <class Tensor>
+void LocalMPO_MPI<Tensor>::
+distribute(int j,
+           Tensor part,
+           std::vector<Tensor> const& S,
+           bool complete)
+    {
+    auto r = size_t(env_->rank());
+    S_.at(j) = (r < S.size()) ? S[r] : Tensor();
+    if(complete)
+        {
+        PH_.at(j) = S_[j] ? part*S_[j] : Tensor();
+        return;
+        }
+    auto v = std::vector<Tensor>(env_->nnodes());
+    if(part) for(auto k : range(S.size())) v[k] = part*S[k];
+    part = Tensor();
+    PH_.at(j) = reduceScatter(*env_,v);
+    }
+
+template <class Tensor>
+void LocalMPO_MPI<Tensor>::
+sumOverNodes(Tensor & T, Tensor & Z, bool cplx) const
+    {
+    if(!Z)
+        {
+        //Check the layout of T on all nodes
+        allReduce(*env_,T);
+        if(!T) return;
+        Z = Tensor(T.inds());
+        detail::allocZero(Z,detail::reduceDiv(T));
+        if(isComplex(T)) doTask(Mult<Cplx>(1.),Z.store());
+        return;
+        }
+    if(!T)
+        {
+        T = Z;
+        }
+    else
+        {
+        if(rank(T) != rank(Z)) Error("LocalMPO_MPI: wrong indices of product");
+        auto inorder = true;
+        for(auto n : range(rank(Z))) if(T.inds()[n] != Z.inds()[n]) inorder = false;
+        if(!inorder) T.order(Z.inds());
+        }
+    detail::allReduceData(*env_,T,cplx || isComplex(Z));
+    }
+
+template <class Tensor>
+Tensor LocalMPO_MPI<Tensor>::
+scatterOverNodes(std::vector<Tensor> & v, std::vector<Tensor> & Z, bool cplx) const
+    {
+    auto r = env_->rank();
+    if(Z.empty())
+        {
+        //Check the layouts of the v[k] on all nodes
+        Z.resize(v.size());
+        auto res = Tensor();
+        for(auto k : range(v.size()))
+            {
+            auto T = std::move(v[k]);
+            reduce(*env_,T,k);
+            if(T)
+                {
+                Z[k] = Tensor(T.inds());
+                detail::allocZero(Z[k],detail::reduceDiv(T));
+                if(isComplex(T)) doTask(Mult<Cplx>(1.),Z[k].store());
+                }
+            if(k == size_t(r)) res = std::move(T);
+            }
+        return res;
+        }
+    auto res = Tensor();
+    for(auto k : range(v.size()))
+        {
+        if(!Z[k]) continue;
+        auto T = std::move(v[k]);
+        if(!T)
+            {
+            T = Z[k];
+            }
+        else
+            {
+            if(rank(T) != rank(Z[k])) Error("LocalMPO_MPI: wrong indices of product");
+            auto inorder = true;
+            for(auto n : range(rank(T))) if(T.inds()[n] != Z[k].inds()[n]) inorder = false;
+            if(!inorder) T.order(Z[k].inds());
+            }
+        detail::reduceData(*env_,T,k,cplx || isComplex(Z[k]));
+        if(k == size_t(r)) res = std::move(T);
+        }
+    return res;
+    }
+
+template <class Tensor>
+Tensor LocalMPO_MPI<Tensor>::
+edgePart(int j, Tensor const& E, Tensor const& S, Tensor const& A) const
+    {
+    if(!S) return Tensor();
+    auto P = E*A;
+    P *= Op_->A(j)*dag(S);
+    P *= dag(prime(A));
+    return P;
+    }
+
+template <class Tensor>
+template <class MPSType>
+void LocalMPO_MPI<Tensor>::
+makeL(MPSType const& psi, int k)
+    {
+    while(LHlim_ < k)
+        {
+        auto j = LHlim_+1;
+        auto& A = psi.A(j);
+        if(LHlim_ == 0)
+            {
+            auto P = A*Op_->A(j);
+            P *= dag(prime(A));
+            distribute(j,std::move(P),LS_[j],true);
+            }
+        else
+            {
+            distribute(j,edgePart(j,PH_.at(j-1),S_.at(j-1),A),LS_[j],false);
+            }
+        LHlim_ = j;
+        }
+    }
+
+template <class Tensor>
+template <class MPSType>
+void LocalMPO_MPI<Tensor>::
+makeR(MPSType const& psi, int k)
+    {
+    auto N = Op_->N();
+    while(RHlim_ > k)
+        {
+        auto j = RHlim_-1;
+        auto& A = psi.A(j);
+        if(RHlim_ == N+1)
+            {
+            auto P = A*Op_->A(j);
+            P *= dag(prime(A));
+            distribute(j,std::move(P),RS_[j],true);
+            }
+        else
+            {
+            distribute(j,edgePart(j,PH_.at(j+1),S_.at(j+1),A),RS_[j],false);
+            }
+        RHlim_ = j;
+        }
+    }
+
+template <class Tensor>
+Real
+dmrg(Environment const& env,
+     MPSt<Tensor>& psi,
+     MPOt<Tensor> H,
+     Sweeps const& sweeps,
+     Args args)
+    {
+    detail::broadcastTensors(env,psi);
+    detail::broadcastTensors(env,H);
+    if(!env.firstNode()) args.add("Quiet",true);
+    auto PH = LocalMPO_MPI<Tensor>(env,H,args);
+    //Every node makes the same svds and Davidson steps,
+    //which must give the same new bond indices and random
+    //vectors on every node. Afterwards (also if the sweeps
+    //throw) the nodes return to the state of their own Index
+    //id generators, so that they neither make Indices with
+    //the same ids independently nor repeat the ids of the
+    //sweeps, and reseed their random number generators.
+    auto seed = detail::indexIDGenerator()();
+    broadcast(env,seed);
+    auto ownIDs = detail::indexIDGenerator();
+    auto ownRNG = 1+int(Global::random()*1E9);
+    auto restore = [&ownIDs,ownRNG]
+        {
+        detail::indexIDGenerator() = ownIDs;
+        seedRNG(ownRNG);
+        };
+    seedIndexIDs(seed);
+    seedRNG(1+int(seed % 1000000007));
+    auto energy = 0.;
+    try
+        {
+        energy = DMRGWorker(psi,PH,sweeps,args);
+        }
+    catch(...)
+        {
+        restore();
+        throw;
+        }
+    restore();
+    return energy;
+    }
+
+} //namespace itensor
+
+#endif
@@ -67,6 +67,11 @@ class LocalMPO_MPS
     int
     size() const { return lmpo_.size(); }
 
+    int
+    numCenter() const { return lmpo_.numCenter(); }
+    void
+    numCenter(int val);
+
     explicit
     operator bool() const { return bool(Op_); }
 
@@ -154,6 +159,17 @@ position(int b, const MPSType& psi)
         }
     }
 
+template <class Tensor>
+void inline LocalMPO_MPS<Tensor>::
+numCenter(int val)
+    {
+    lmpo_.numCenter(val);
+    for(auto& M : lmps_)
+        {
+        M.numCenter(val);
+        }
+    }
+
 } //namespace itensor
 
 #endif
@@ -8,11 +8,24 @@
 
 namespace itensor {
 
+//
+// LocalMPOSet represents a sum of projected
+// MPOs H_1+H_2+...+H_n, each with its own
+// LocalMPO and edge tensors.
+//
+// If the named argument "NThread" is greater
+// than 1, the terms are processed concurrently
+// by position(), product() and deltaRho(),
+// each writing to its own buffer, with the
+// results summed at the end.
+//
+
 template <class Tensor>
 class LocalMPOSet
     {
     std::vector<MPOt<Tensor>> const* Op_ = nullptr;
     std::vector<LocalMPO<Tensor>> lmpo_;
+    int nthread_ = 1;
     public:
 
     LocalMPOSet() { }
@@ -90,6 +103,15 @@ class LocalMPOSet
     explicit
     operator bool() const { return bool(Op_); }
 
+    int
+    nthread() const { return nthread_; }
+    void
+    nthread(int val) 
+        { 
+        if(val < 1) Error("NThread must be set >= 1");
+        nthread_ = val; 
+        }
+
     bool
     doWrite() const { return lmpo_.front().doWrite(); }
     void
@@ -98,6 +120,26 @@ class LocalMPOSet
         for(auto& lm : lmpo_) lm.doWrite(val);
         }
 
+    private:
+
+    //Call f(n) for each term n, distributing
+    //the terms over nthread_ threads
+    template<typename Func>
+    void
+    forEachTerm(Func&& f) const
+        {
+        auto nt = std::min(size_t(nthread_),lmpo_.size());
+        if(nt <= 1)
+            {
+            for(auto n : range(lmpo_.size())) f(n);
+            return;
+            }
+        detail::parallelFor(nt,[&](size_t t)
+            {
+            for(auto n = t; n < lmpo_.size(); n += nt) f(n);
+            });
+        }
+
     };
 
 template <class Tensor>
@@ -112,6 +154,7 @@ LocalMPOSet(std::vector<MPOt<Tensor>> const& Op,
         {
         lmpo_[n] = LocalMPOT(Op.at(n));
         }
+    if(args.defined("NThread")) nthread(args.getInt("NThread"));
     }
 
 template <class Tensor>
@@ -126,9 +169,13 @@ LocalMPOSet(std::vector<MPOt<Tensor>> const& H,
     lmpo_(H.size())
     { 
     using LocalMPOT = LocalMPO<Tensor>;
+    if(args.defined("NThread")) nthread(args.getInt("NThread"));
+    //Threads are used across terms, not within them
+    auto targs = args;
+    targs.add("NThread",1);
     for(auto n : range(lmpo_.size()))
         {
-        lmpo_[n] = LocalMPOT(H.at(n),LH.at(n),LHlim,RH.at(n),RHlim,args);
+        lmpo_[n] = LocalMPOT(H.at(n),LH.at(n),LHlim,RH.at(n),RHlim,targs);
         }
     }
 
@@ -137,14 +184,21 @@ void inline LocalMPOSet<Tensor>::
 product(Tensor const& phi, 
         Tensor & phip) const
     {
-    lmpo_.front().product(phi,phip);
-
-    Tensor phi_n;
-    for(auto n : range(1,lmpo_.size()))
+    if(nthread_ <= 1)
         {
-        lmpo_[n].product(phi,phi_n);
-        phip += phi_n;
+        lmpo_.front().product(phi,phip);
+
+        Tensor phi_n;
+        for(auto n : range(1,lmpo_.size()))
+            {
+            lmpo_[n].product(phi,phi_n);
+            phip += phi_n;
+            }
+        return;
         }
+    auto parts = std::vector<Tensor>(lmpo_.size());
+    forEachTerm([&](size_t n) { lmpo_[n].product(phi,parts[n]); });
+    phip = detail::sumParts(std::move(parts));
     }
 
 template <class Tensor>
@@ -166,12 +220,9 @@ deltaRho(Tensor const& AA,
          Tensor const& comb, 
          Direction dir) const
     {
-    Tensor delta = lmpo_.front().deltaRho(AA,comb,dir);
-    for(auto n : range(1,lmpo_.size()))
-        {
-        delta += lmpo_[n].deltaRho(AA,comb,dir);
-        }
-    return delta;
+    auto parts = std::vector<Tensor>(lmpo_.size());
+    forEachTerm([&](size_t n) { parts[n] = lmpo_[n].deltaRho(AA,comb,dir); });
+    return detail::sumParts(std::move(parts));
     }
 
 template <class Tensor>
@@ -192,10 +243,7 @@ void inline LocalMPOSet<Tensor>::
 position(int b, 
          MPSType const& psi)
     {
-    for(auto n : range(lmpo_.size()))
-        {
-        lmpo_[n].position(b,psi);
-        }
+    forEachTerm([&](size_t n) { lmpo_[n].position(b,psi); });
     }
 
 template <class Tensor>
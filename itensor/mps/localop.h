@@ -4,6 +4,7 @@
 //
 #ifndef __ITENSOR_LOCAL_OP
 #define __ITENSOR_LOCAL_OP
+#include <map>
 #include "itensor/iqtensor.h"
 //#include "itensor/util/print_macro.h"
 
@@ -28,7 +29,181 @@ namespace itensor {
 //  can even be null in which case
 //  they will not be used.)
 //
+// For single-site algorithms Op2
+// can be omitted, in which case
+// LocalOp represents
+//
+//   .-      -.
+//   |    |   |
+//   L - Op - R
+//   |    |   |
+//   '-      -'
+//
+// The order in which phi, L, Op1, Op2 and R
+// are contracted in product() is chosen by
+// minimizing an estimate of the number of
+// floating point operations (taking the
+// block-sparse structure of IQTensors into
+// account). The order is computed on the first
+// call to product() after update() and reused
+// for subsequent calls, such as the iterations
+// of the Davidson algorithm.
+//
+
+namespace detail {
+
+//Total dimension of each (arrow-weighted)
+//QN sector of a set of indices
+using SectorDims = std::map<QN,Real>;
+
+inline SectorDims
+sectorDims(Index const& i) { return SectorDims{{QN(),Real(i.m())}}; }
+
+inline SectorDims
+sectorDims(IQIndex const& I)
+    {
+    auto D = SectorDims{};
+    for(auto n : range1(I.nindex())) D[I.dir()*I.qn(n)] += I.index(n).m();
+    return D;
+    }
+
+template<typename IndexT>
+SectorDims
+sectorDims(std::vector<IndexT> const& inds)
+    {
+    auto D = SectorDims{{QN(),1.}};
+    for(auto& I : inds)
+        {
+        auto DI = sectorDims(I);
+        auto N = SectorDims{};
+        for(auto& a : D) 
+        for(auto& b : DI) 
+            {
+            N[a.first+b.first] += a.second*b.second;
+            }
+        D.swap(N);
+        }
+    return D;
+    }
+
+inline QN
+fluxOf(ITensor const& T) { return QN(); }
+
+inline QN
+fluxOf(IQTensor const& T) { return div(T); }
+
+//Index structure of a tensor appearing in
+//a contraction, used to plan the contraction
+//without actually performing it
+template<typename IndexT>
+struct ContractNode
+    {
+    std::vector<IndexT> inds;
+    QN flux;
+    };
 
+//Contract the index structures A and B,
+//returning the estimated cost
+//(number of multiply-adds) in "cost"
+template<typename IndexT>
+ContractNode<IndexT>
+contractNodes(ContractNode<IndexT> const& A,
+              ContractNode<IndexT> const& B,
+              Real & cost)
+    {
+    auto has = [](std::vector<IndexT> const& v, IndexT const& I)
+        {
+        for(auto& J : v) if(J == I) return true;
+        return false;
+        };
+    auto C = ContractNode<IndexT>{};
+    auto Aonly = std::vector<IndexT>{},
+         Bonly = std::vector<IndexT>{},
+         common = std::vector<IndexT>{};
+    for(auto& I : A.inds) 
+        {
+        if(has(B.inds,I)) common.push_back(I);
+        else              Aonly.push_back(I);
+        }
+    for(auto& I : B.inds) 
+        {
+        if(!has(A.inds,I)) Bonly.push_back(I);
+        }
+    //Only blocks where the sectors of the
+    //contracted indices are compatible with
+    //the fluxes of both A and B contribute
+    auto DA = sectorDims(Aonly),
+         DB = sectorDims(Bonly),
+         DC = sectorDims(common);
+    cost = 1.;
+    for(auto& c : DC)
+        {
+        auto a = DA.find(A.flux-c.first);
+        if(a == DA.end()) continue;
+        auto b = DB.find(B.flux+c.first);
+        if(b == DB.end()) continue;
+        cost += c.second*a->second*b->second;
+        }
+    C.inds = std::move(Aonly);
+    C.inds.insert(C.inds.end(),Bonly.begin(),Bonly.end());
+    C.flux = A.flux+B.flux;
+    return C;
+    }
+
+//Exhaustive search for the pairwise contraction
+//sequence of "nodes" having the lowest total cost.
+//Each step (i,j) of the order contracts node j
+//into node i (i < j) and removes node j.
+template<typename IndexT>
+Real
+optimalOrder(std::vector<ContractNode<IndexT>> const& nodes,
+             std::vector<std::pair<int,int>> & order)
+    {
+    order.clear();
+    auto n = int(nodes.size());
+    if(n <= 1) return 0.;
+
+    auto shareIndex = [](ContractNode<IndexT> const& A,
+                         ContractNode<IndexT> const& B)
+        {
+        for(auto& I : A.inds) 
+        for(auto& J : B.inds) 
+            {
+            if(I == J) return true;
+            }
+        return false;
+        };
+    //Avoid outer products unless nothing else is possible
+    auto connected = false;
+    for(auto i : range(n))
+    for(auto j : range(i+1,n))
+        {
+        if(shareIndex(nodes[i],nodes[j])) connected = true;
+        }
+
+    auto best = -1.;
+    auto sub = std::vector<std::pair<int,int>>{};
+    for(auto i : range(n))
+    for(auto j : range(i+1,n))
+        {
+        if(connected && !shareIndex(nodes[i],nodes[j])) continue;
+        auto cost = 0.;
+        auto next = nodes;
+        next[i] = contractNodes(nodes[i],nodes[j],cost);
+        next.erase(next.begin()+j);
+        if(best >= 0 && cost >= best) continue;
+        cost += optimalOrder(next,sub);
+        if(best < 0 || cost < best)
+            {
+            best = cost;
+            order.assign(1,std::make_pair(i,j));
+            order.insert(order.end(),sub.begin(),sub.end());
+            }
+        }
+    return best;
+    }
+
+} //namespace detail
 
 template <class Tensor>
 class LocalOp
@@ -38,6 +213,8 @@ class LocalOp
     Tensor const* L_;
     Tensor const* R_;
     mutable long size_;
+    mutable std::vector<std::pair<int,int>> order_;
+    mutable std::vector<typename Tensor::index_type> order_inds_;
     public:
 
     using IndexT = typename Tensor::index_type;
@@ -92,6 +269,12 @@ class LocalOp
            Tensor const& L, 
            Tensor const& R);
 
+    //One-site version: Op2 is null
+    void
+    update(Tensor const& Op, 
+           Tensor const& L, 
+           Tensor const& R);
+
     Tensor const&
     Op1() const 
         { 
@@ -103,6 +286,7 @@ class LocalOp
     Op2() const 
         { 
         if(!(*this)) Error("LocalOp is default constructed");
+        if(Op2IsNull()) Error("LocalOp is a one-site operator (Op2 is null)");
         return *Op2_;
         }
 
@@ -128,6 +312,14 @@ class LocalOp
     bool
     RIsNull() const;
 
+    bool
+    Op2IsNull() const { return Op2_ == nullptr; }
+
+    private:
+
+    void
+    productTensors(Tensor const& phi, std::vector<Tensor> & T) const;
+
     };
 
 template <class Tensor>
@@ -180,6 +372,7 @@ update(const Tensor& Op1, const Tensor& Op2)
     L_ = nullptr;
     R_ = nullptr;
     size_ = -1;
+    order_.clear();
     }
 
 template <class Tensor>
@@ -192,6 +385,31 @@ update(const Tensor& Op1, const Tensor& Op2,
     R_ = &R;
     }
 
+template <class Tensor>
+void inline LocalOp<Tensor>::
+productTensors(Tensor const& phi, std::vector<Tensor> & T) const
+    {
+    T.clear();
+    T.push_back(phi);
+    if(!LIsNull()) T.push_back(*L_);
+    T.push_back(*Op1_);
+    if(Op2_) T.push_back(*Op2_);
+    if(!RIsNull()) T.push_back(*R_);
+    }
+
+template <class Tensor>
+void inline LocalOp<Tensor>::
+update(const Tensor& Op, 
+       const Tensor& L, const Tensor& R)
+    {
+    Op1_ = &Op;
+    Op2_ = nullptr;
+    L_ = &L;
+    R_ = &R;
+    size_ = -1;
+    order_.clear();
+    }
+
 template <class Tensor>
 bool inline LocalOp<Tensor>::
 LIsNull() const
@@ -215,30 +433,34 @@ product(Tensor const& phi,
     {
     if(!(*this)) Error("LocalOp is null");
 
-    auto& Op1 = *Op1_;
-    auto& Op2 = *Op2_;
+    auto T = std::vector<Tensor>{};
+    productTensors(phi,T);
 
-    if(LIsNull())
+    auto sameInds = (order_inds_.size() == size_t(phi.r()));
+    for(auto n : range(order_inds_.size()))
         {
-        phip = phi;
-
-        if(!RIsNull()) 
-            phip *= R(); //m^3 k d
-
-        phip *= Op2; //m^2 k^2
-        phip *= Op1; //m^2 k^2
+        if(!sameInds) break;
+        sameInds = (order_inds_[n] == phi.inds()[n]);
         }
-    else
+    if(order_.empty() || !sameInds)
         {
-        phip = phi * L(); //m^3 k d
-
-        phip *= Op1; //m^2 k^2
-        phip *= Op2; //m^2 k^2
-
-        if(!RIsNull()) 
-            phip *= R();
+        auto nodes = std::vector<detail::ContractNode<IndexT>>(T.size());
+        for(auto n : range(T.size()))
+            {
+            for(auto& I : T[n].inds()) nodes[n].inds.push_back(I);
+            nodes[n].flux = detail::fluxOf(T[n]);
+            }
+        detail::optimalOrder(nodes,order_);
+        order_inds_.clear();
+        for(auto& I : phi.inds()) order_inds_.push_back(I);
         }
 
+    for(auto& p : order_)
+        {
+        T[p.first] *= T[p.second];
+        T.erase(T.begin()+p.second);
+        }
+    phip = std::move(T.front());
     phip.mapprime(1,0);
     }
 
@@ -266,7 +488,7 @@ deltaRho(Tensor const& AA,
     else //dir == Fromright
         {
         if(!RIsNull()) drho *= R();
-        drho *= (*Op2_);
+        drho *= (Op2_ ? *Op2_ : *Op1_);
         }
     drho.noprime();
     drho = combine * drho;
@@ -288,7 +510,6 @@ diag() const
     if(!(*this)) Error("LocalOp is null");
 
     auto& Op1 = *Op1_;
-    auto& Op2 = *Op2_;
 
     //lambda helper function:
     auto findIndPair = [](Tensor const& T) {
@@ -306,9 +527,12 @@ diag() const
     auto Diag = Op1 * delta(toTie,prime(toTie),prime(toTie,2));
     Diag.noprime();
 
-    toTie = noprime(findtype(Op2,Site));
-    auto Diag2 = Op2 * delta(toTie,prime(toTie),prime(toTie,2));
-    Diag *= noprime(Diag2);
+    if(Op2_)
+        {
+        toTie = noprime(findtype(*Op2_,Site));
+        auto Diag2 = (*Op2_) * delta(toTie,prime(toTie),prime(toTie,2));
+        Diag *= noprime(Diag2);
+        }
 
     if(!LIsNull())
         {
@@ -379,7 +603,7 @@ size() const
             }
 
         size_ *= findtype(*Op1_,Site).m();
-        size_ *= findtype(*Op2_,Site).m();
+        if(Op2_) size_ *= findtype(*Op2_,Site).m();
         }
     return size_;
     }
@@ -0,0 +1,366 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_LOCALSPARSEMPO
+#define __ITENSOR_LOCALSPARSEMPO
+#include "itensor/mps/sparsempo.h"
+
+namespace itensor {
+
+//
+// The LocalSparseMPO class projects a SparseMPO
+// into the reduced Hilbert space of one or two
+// sites of an MPS, in the same way as LocalMPO.
+//
+// The edge tensors are stored "sliced" along the
+// MPO link index: L(a) for each value a of the MPO
+// link (a null tensor if that component vanishes).
+// H|phi> and the edge updates then loop over the
+// non-zero entries of the SparseMPO only, and apply
+// identity entries by priming instead of contracting.
+//
+
+template <class Tensor>
+class LocalSparseMPO
+    {
+    public:
+    using IndexT = typename Tensor::index_type;
+    using EdgeT = std::vector<Tensor>;
+    private:
+    SparseMPOt<Tensor> const* Op_ = nullptr;
+    std::vector<EdgeT> PL_,
+                       PR_;
+    int LHlim_ = -1,
+        RHlim_ = -1;
+    int nc_ = 2;
+    long size_ = -1;
+    public:
+
+    LocalSparseMPO() { }
+
+    LocalSparseMPO(SparseMPOt<Tensor> const& H,
+                   Args const& args = Args::global());
+
+    //
+    // Sparse Matrix Methods
+    //
+
+    void
+    product(Tensor const& phi, Tensor & phip) const;
+
+    Real
+    expect(Tensor const& phi) const;
+
+    Tensor
+    deltaRho(Tensor const& AA,
+             Tensor const& combine,
+             Direction dir) const;
+
+    long
+    size() const;
+
+    //
+    // position(b,psi) uses the MPS psi
+    // to adjust the edge tensors such
+    // that the MPO tensors at positions
+    // b and b+1 are exposed
+    // (only the MPO tensor at b if
+    //  numCenter() == 1)
+    //
+    template <class MPSType>
+    void
+    position(int b, MPSType const& psi);
+
+    int
+    position() const;
+
+    //
+    // Accessor Methods
+    //
+
+    void
+    reset()
+        {
+        LHlim_ = 0;
+        RHlim_ = Op_->N()+1;
+        }
+
+    //Left edge tensor at current bond, sliced
+    //along the MPO link (empty at the left edge)
+    EdgeT const&
+    L() const { return PL_.at(LHlim_); }
+
+    //Right edge tensor at current bond, sliced
+    //along the MPO link (empty at the right edge)
+    EdgeT const&
+    R() const { return PR_.at(RHlim_); }
+
+    SparseMPOt<Tensor> const&
+    H() const
+        {
+        if(!Op_) Error("LocalSparseMPO is null");
+        return *Op_;
+        }
+
+    int
+    numCenter() const { return nc_; }
+    void
+    numCenter(int val)
+        {
+        if(val < 1 || val > 2) Error("LocalSparseMPO supports numCenter 1 or 2");
+        nc_ = val;
+        }
+
+    explicit operator bool() const { return Op_ != nullptr; }
+
+    bool
+    doWrite() const { return false; }
+    void
+    doWrite(bool val)
+        {
+        if(val) Error("Write to disk not supported for LocalSparseMPO");
+        }
+
+    int
+    leftLim() const { return LHlim_; }
+
+    int
+    rightLim() const { return RHlim_; }
+
+    private:
+
+    template <class MPSType>
+    void
+    makeL(MPSType const& psi, int k);
+
+    template <class MPSType>
+    void
+    makeR(MPSType const& psi, int k);
+
+    //Contract phi with each non-null component
+    //of the edge E (phi itself at the ends)
+    std::vector<Tensor>
+    withEdge(EdgeT const& E, long size, Tensor const& phi) const;
+
+    //Sum the components of Z contracted with
+    //the edge E (just their sum at the ends)
+    Tensor
+    closeEdge(std::vector<Tensor> const& Z, EdgeT const& E) const;
+
+    //Apply the entries of site j to X, moving from
+    //rows to columns (Fromleft) or columns to rows
+    std::vector<Tensor>
+    applySite(int j, std::vector<Tensor> const& X, Direction dir) const;
+    };
+
+template <class Tensor>
+LocalSparseMPO<Tensor>::
+LocalSparseMPO(SparseMPOt<Tensor> const& H,
+               Args const& args)
+    : Op_(&H),
+      PL_(H.N()+2),
+      PR_(H.N()+2),
+      LHlim_(0),
+      RHlim_(H.N()+1)
+    {
+    if(args.defined("NumCenter"))
+        numCenter(args.getInt("NumCenter"));
+    }
+
+template <class Tensor>
+std::vector<Tensor> LocalSparseMPO<Tensor>::
+withEdge(EdgeT const& E, long size, Tensor const& phi) const
+    {
+    if(E.empty()) return std::vector<Tensor>(1,phi);
+    auto X = std::vector<Tensor>(size);
+    for(auto a : range(E.size()))
+        {
+        if(E[a]) X[a] = E[a]*phi;
+        }
+    return X;
+    }
+
+template <class Tensor>
+Tensor LocalSparseMPO<Tensor>::
+closeEdge(std::vector<Tensor> const& Z, EdgeT const& E) const
+    {
+    auto res = Tensor();
+    for(auto a : range(Z.size()))
+        {
+        if(!Z[a]) continue;
+        if(E.empty()) detail::addTo(res,Z[a]);
+        else if(E.at(a)) detail::addTo(res,Z[a]*E[a]);
+        }
+    return res;
+    }
+
+template <class Tensor>
+std::vector<Tensor> LocalSparseMPO<Tensor>::
+applySite(int j, std::vector<Tensor> const& X, Direction dir) const
+    {
+    auto& H = *Op_;
+    auto Y = std::vector<Tensor>(dir==Fromleft ? H.cols(j) : H.rows(j));
+    for(auto& e : H.elems(j))
+        {
+        auto from = (dir==Fromleft ? e.row : e.col);
+        auto to = (dir==Fromleft ? e.col : e.row);
+        if(!X.at(from)) continue;
+        detail::addTo(Y.at(to),detail::applyElem(e,X[from],H.site(j)));
+        }
+    return Y;
+    }
+
+template <class Tensor>
+void LocalSparseMPO<Tensor>::
+product(Tensor const& phi, Tensor & phip) const
+    {
+    if(!(*this)) Error("LocalSparseMPO is null");
+    auto b = position();
+
+    auto Y = withEdge(L(),Op_->rows(b),phi);
+    Y = applySite(b,Y,Fromleft);
+    if(nc_ == 2) Y = applySite(b+1,Y,Fromleft);
+    phip = closeEdge(Y,R());
+
+    if(!phip) phip = 0.*phi;
+    else      phip.mapprime(1,0);
+    }
+
+template <class Tensor>
+Real LocalSparseMPO<Tensor>::
+expect(Tensor const& phi) const
+    {
+    Tensor phip;
+    product(phi,phip);
+    return (dag(phip) * phi).real();
+    }
+
+template <class Tensor>
+Tensor LocalSparseMPO<Tensor>::
+deltaRho(Tensor const& AA,
+         Tensor const& combine,
+         Direction dir) const
+    {
+    auto b = position();
+    auto D = std::vector<Tensor>{};
+    if(dir == Fromleft)
+        {
+        D = applySite(b,withEdge(L(),Op_->rows(b),AA),Fromleft);
+        }
+    else //dir == Fromright
+        {
+        auto j = b+nc_-1;
+        D = applySite(j,withEdge(R(),Op_->cols(j),AA),Fromright);
+        }
+
+    //Same as LocalOp::deltaRho, summing over
+    //the components of the (sliced) MPO link
+    auto drho = Tensor();
+    for(auto& d : D)
+        {
+        if(!d) continue;
+        auto cd = combine * noprime(d);
+        auto ci = commonIndex(combine,cd);
+        detail::addTo(drho,cd*dag(prime(cd,ci)));
+        }
+
+    //Expedient to ensure drho is Hermitian
+    drho = drho + dag(swapPrime(drho,0,1));
+    drho /= 2.;
+
+    return drho;
+    }
+
+template <class Tensor>
+long LocalSparseMPO<Tensor>::
+size() const
+    {
+    if(size_ < 0) Error("LocalSparseMPO: position not set");
+    return size_;
+    }
+
+template <class Tensor>
+template <class MPSType>
+void LocalSparseMPO<Tensor>::
+position(int b, MPSType const& psi)
+    {
+    if(!(*this)) Error("LocalSparseMPO is null");
+
+    makeL(psi,b-1);
+    makeR(psi,b+nc_);
+
+    LHlim_ = b-1;
+    RHlim_ = b+nc_;
+
+    //Linear size of the local problem: product of the
+    //dimensions of psi's indices on the nc_ center sites,
+    //excluding the links between them
+    size_ = 1;
+    for(auto j : range(b,b+nc_))
+        {
+        for(auto& I : psi.A(j).inds())
+            {
+            auto internal = (j > b && hasindex(psi.A(j-1),I))
+                         || (j+1 < b+nc_ && hasindex(psi.A(j+1),I));
+            if(!internal) size_ *= I.m();
+            }
+        }
+    }
+
+template <class Tensor>
+int LocalSparseMPO<Tensor>::
+position() const
+    {
+    if(RHlim_-LHlim_ != (nc_+1))
+        {
+        throw ITError("LocalSparseMPO position not set");
+        }
+    return LHlim_+1;
+    }
+
+template <class Tensor>
+template <class MPSType>
+void LocalSparseMPO<Tensor>::
+makeL(MPSType const& psi, int k)
+    {
+    while(LHlim_ < k)
+        {
+        auto j = LHlim_+1;
+        auto& A = psi.A(j);
+        auto Y = applySite(j,withEdge(PL_.at(j-1),Op_->rows(j),A),Fromleft);
+        auto Adag = dag(prime(A));
+        for(auto& y : Y) 
+            {
+            if(y) y *= Adag;
+            if(detail::isZero(y)) y = Tensor();
+            }
+        PL_.at(j) = std::move(Y);
+        LHlim_ = j;
+        }
+    }
+
+template <class Tensor>
+template <class MPSType>
+void LocalSparseMPO<Tensor>::
+makeR(MPSType const& psi, int k)
+    {
+    while(RHlim_ > k)
+        {
+        auto j = RHlim_-1;
+        auto& A = psi.A(j);
+        auto Y = applySite(j,withEdge(PR_.at(j+1),Op_->cols(j),A),Fromright);
+        auto Adag = dag(prime(A));
+        for(auto& y : Y) 
+            {
+            if(y) y *= Adag;
+            if(detail::isZero(y)) y = Tensor();
+            }
+        PR_.at(j) = std::move(Y);
+        RHlim_ = j;
+        }
+    }
+
+} //namespace itensor
+
+#endif
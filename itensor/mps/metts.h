@@ -0,0 +1,377 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_METTS_H
+#define __ITENSOR_METTS_H
+
+#include "itensor/mps/mpo.h"
+#include "itensor/mps/sampling.h"
+#include "itensor/util/threadpool.h"
+
+namespace itensor {
+
+//
+// Collapse psi into a random product state, choosing the
+// state of each site j = 1,...,N in turn with the probability
+// given by psi (conditioned on the states chosen for sites
+// 1,...,j-1), using the random number generator rng.
+//
+// The basis can be "Z" (the basis states of each site) or
+// "X" (the states (|1>+|2>)/sqrt(2) and (|1>-|2>)/sqrt(2)
+// of two-state sites). Returns the number of the state chosen
+// at each site j (element j, with element 0 unused); psi is
+// replaced by the product state, with bond dimension 1.
+//
+template <class RNG>
+std::vector<int>
+collapse(MPS & psi,
+         std::string const& basis,
+         RNG & rng);
+
+//
+// Averages of observables over METTS, kept as running sums
+// for each Markov chain so that measurements can be added
+// as they are made, from one thread per chain.
+//
+class METTSResults
+    {
+    long nchain_ = 0,
+         nobs_ = 0;
+    //Number of measurements, and sums of the measured values
+    //and of their squares, of each chain (sums for chain c and
+    //observable n at c*nobs_+n)
+    std::vector<Real> count_,
+                      sum_,
+                      sum2_;
+    public:
+
+    METTSResults() { }
+
+    METTSResults(long nchain, long nobs)
+      : nchain_(nchain),
+        nobs_(nobs),
+        count_(nchain,0.),
+        sum_(nchain*nobs,0.),
+        sum2_(nchain*nobs,0.)
+        { }
+
+    long
+    nchain() const { return nchain_; }
+
+    long
+    nobs() const { return nobs_; }
+
+    //Add the values vals of the observables measured in a
+    //METTS of chain c. Calls for different chains can be
+    //made concurrently.
+    void
+    add(long c, std::vector<Real> const& vals);
+
+    //Total number of measurements
+    long
+    count() const;
+
+    //Number of measurements of chain c
+    long
+    count(long c) const { return long(count_.at(c)); }
+
+    //Average of observable n over all measurements
+    Real
+    avg(long n) const;
+
+    //Average of observable n over the measurements of chain c
+    Real
+    avg(long c, long n) const;
+
+    //Error bar of avg(n). With two or more chains it is the
+    //standard error of the chain averages, which are
+    //independent; with one chain it is the standard error of
+    //the measurements, which is an underestimate when
+    //successive METTS are correlated.
+    Real
+    err(long n) const;
+
+    //Add the measurements of other (made with the same
+    //number of chains and observables)
+    void
+    merge(METTSResults const& other);
+
+    //Running sums, for communicating the results
+    std::vector<Real>&
+    counts() { return count_; }
+    std::vector<Real>&
+    sums() { return sum_; }
+    std::vector<Real>&
+    sums2() { return sum2_; }
+    };
+
+//
+// Minimally entangled typical thermal states (METTS)
+// sampling of thermal averages at inverse temperature beta.
+//
+// Runs independent Markov chains concurrently, each starting
+// from the product state psi0. A step of a chain evolves its
+// product state by applying expH nstep times (with expH
+// approximately exp(-tau H) and nstep*tau = beta/2, for
+// example made with toExpH), normalizes it, measures
+// <psi|ops[n]|psi> for each n if past the warm-up, and
+// collapses it into a new product state.
+//
+// Chain c draws its random numbers from its own generator,
+// seeded from "Seed" and c, so that the results do not
+// depend on the number of threads.
+//
+// Arguments recognized:
+// o "NChain" (default: 1) - number of chains
+// o "NMETTS" (default: 100) - number of METTS measured
+//   in each chain
+// o "NWarm" (default: 5) - number of steps of each chain
+//   before the first measurement
+// o "Collapse" (default: "ZX") - basis of the collapse
+//   (see collapse above): "Z", "X" or "ZX" to alternate the
+//   two bases, starting with "Z"
+// o "Seed" (default: random) - seed of the random numbers
+// o "NThread" (default: 1) - number of threads running chains
+// o "Quiet" (default: false) - if false, print the values
+//   measured in each METTS
+// o "Maxm", "Cutoff" - truncation of the time evolution
+//   (see exactApplyMPO)
+//
+METTSResults
+metts(MPS const& psi0,
+      MPO const& expH,
+      int nstep,
+      std::vector<MPO> const& ops,
+      Args const& args = Args::global());
+
+
+namespace detail {
+
+//Run the chains in the list chains (numbers of chains
+//among all chains of res), adding to res
+void inline
+runMETTSChains(std::vector<long> const& chains,
+               MPS const& psi0,
+               MPO const& expH,
+               int nstep,
+               std::vector<MPO> const& ops,
+               METTSResults & res,
+               int seed,
+               Args const& args)
+    {
+    auto nmetts = args.getInt("NMETTS",100);
+    auto nwarm = args.getInt("NWarm",5);
+    auto basis = args.getString("Collapse","ZX");
+    auto quiet = args.getBool("Quiet",false);
+    auto nthread = args.getInt("NThread",1);
+    if(nthread < 1) Error("NThread must be set >= 1");
+    if(nstep < 1) Error("metts: nstep must be >= 1");
+    if(basis != "Z" && basis != "X" && basis != "ZX")
+        {
+        Error("Collapse basis '" + basis + "' not recognized");
+        }
+
+    auto runChain = [&](long c)
+        {
+        std::seed_seq sq{seed,int(c)};
+        auto rng = std::mt19937(sq);
+        auto psi = psi0;
+        for(auto step : range1(nwarm+nmetts))
+            {
+            for(auto n = 0; n < nstep; ++n)
+                {
+                psi = exactApplyMPO(expH,psi,args);
+                psi.Aref(1) /= norm(psi.A(1));
+                }
+            if(step > nwarm)
+                {
+                auto vals = std::vector<Real>(ops.size());
+                for(auto n : range(ops.size())) vals[n] = overlap(psi,ops[n],psi);
+                res.add(c,vals);
+                if(!quiet)
+                    {
+                    auto s = format("Chain %d METTS %d:",c,step-nwarm);
+                    for(auto v : vals) s += format(" %.12f",v);
+                    println(s);
+                    }
+                }
+            auto b = basis;
+            if(basis == "ZX") b = (step%2 == 1) ? "Z" : "X";
+            collapse(psi,b,rng);
+            }
+        };
+
+    auto nt = std::min(size_t(nthread),chains.size());
+    parallelFor(nt,[&](size_t t)
+        {
+        for(auto k = t; k < chains.size(); k += nt) runChain(chains[k]);
+        });
+    }
+
+} //namespace detail
+
+template <class RNG>
+std::vector<int>
+collapse(MPS & psi,
+         std::string const& basis,
+         RNG & rng)
+    {
+    auto N = psi.N();
+    auto dist = std::uniform_real_distribution<Real>(0.,1.);
+    auto states = std::vector<int>(N+1,0);
+    auto prod = std::vector<ITensor>(N+1);
+
+    psi.position(1);
+    auto A = psi.A(1);
+    for(auto j : range1(N))
+        {
+        auto s = findtype(psi.A(j),Site);
+        auto basisState = [&](int k) -> ITensor
+            {
+            if(basis == "Z") return setElt(s(k));
+            if(basis != "X") Error("Collapse basis '" + basis + "' not recognized");
+            if(s.m() != 2) Error("Collapse in the X basis requires two-state sites");
+            auto e = ITensor(s);
+            e.set(s(1),1./std::sqrt(2.));
+            e.set(s(2),(k == 1 ? 1. : -1.)/std::sqrt(2.));
+            return e;
+            };
+        auto nstate = (basis == "X") ? 2 : s.m();
+
+        //A is the wavefunction of sites j,...,N given the
+        //states of sites 1,...,j-1, with norm 1
+        auto r = dist(rng);
+        auto k = 1;
+        auto B = dag(basisState(1))*A;
+        for(auto p = sqr(norm(B)); r > p && k < nstate; p += sqr(norm(B)))
+            {
+            ++k;
+            B = dag(basisState(k))*A;
+            }
+        states.at(j) = k;
+        prod.at(j) = basisState(k);
+        if(j < N)
+            {
+            A = B*psi.A(j+1);
+            A /= norm(A);
+            }
+        }
+
+    auto links = std::vector<Index>(N+1);
+    for(auto b : range1(N-1)) links.at(b) = Index(nameint("l",b),1,Link);
+    for(auto j : range1(N))
+        {
+        auto& P = prod.at(j);
+        if(j > 1) P *= setElt(links.at(j-1)(1));
+        if(j < N) P *= setElt(links.at(j)(1));
+        psi.setA(j,P);
+        }
+    psi.position(1);
+    return states;
+    }
+
+void inline METTSResults::
+add(long c, std::vector<Real> const& vals)
+    {
+    if(long(vals.size()) != nobs_) Error("METTSResults: wrong number of values");
+    count_.at(c) += 1;
+    for(auto n : range(nobs_))
+        {
+        sum_.at(c*nobs_+n) += vals[n];
+        sum2_.at(c*nobs_+n) += vals[n]*vals[n];
+        }
+    }
+
+long inline METTSResults::
+count() const
+    {
+    auto n = 0L;
+    for(auto x : count_) n += long(x);
+    return n;
+    }
+
+Real inline METTSResults::
+avg(long n) const
+    {
+    auto tot = count();
+    if(tot == 0) return 0;
+    auto s = 0.;
+    for(auto c : range(nchain_)) s += sum_.at(c*nobs_+n);
+    return s/tot;
+    }
+
+Real inline METTSResults::
+avg(long c, long n) const
+    {
+    if(count_.at(c) == 0) return 0;
+    return sum_.at(c*nobs_+n)/count_.at(c);
+    }
+
+Real inline METTSResults::
+err(long n) const
+    {
+    auto nc = 0L;
+    for(auto x : count_) if(x > 0) ++nc;
+    if(nc >= 2)
+        {
+        auto a = 0.,
+             a2 = 0.;
+        for(auto c : range(nchain_))
+            {
+            if(count_[c] == 0) continue;
+            auto m = avg(c,n);
+            a += m;
+            a2 += m*m;
+            }
+        a /= nc;
+        a2 /= nc;
+        return std::sqrt(std::max(0.,a2-a*a)/(nc-1));
+        }
+    auto tot = count();
+    if(tot < 2) return 0;
+    auto s = 0.,
+         s2 = 0.;
+    for(auto c : range(nchain_))
+        {
+        s += sum_.at(c*nobs_+n);
+        s2 += sum2_.at(c*nobs_+n);
+        }
+    auto a = s/tot;
+    return std::sqrt(std::max(0.,s2/tot-a*a)/(tot-1));
+    }
+
+void inline METTSResults::
+merge(METTSResults const& other)
+    {
+    if(other.nchain_ != nchain_ || other.nobs_ != nobs_)
+        {
+        Error("METTSResults: cannot merge results of different sizes");
+        }
+    for(auto c : range(count_.size())) count_[c] += other.count_[c];
+    for(auto i : range(sum_.size()))
+        {
+        sum_[i] += other.sum_[i];
+        sum2_[i] += other.sum2_[i];
+        }
+    }
+
+METTSResults inline
+metts(MPS const& psi0,
+      MPO const& expH,
+      int nstep,
+      std::vector<MPO> const& ops,
+      Args const& args)
+    {
+    auto nchain = args.getInt("NChain",1);
+    if(nchain < 1) Error("NChain must be set >= 1");
+    auto res = METTSResults(nchain,ops.size());
+    auto chains = std::vector<long>(nchain);
+    for(auto c : range(nchain)) chains[c] = c;
+    detail::runMETTSChains(chains,psi0,expH,nstep,ops,res,detail::randomSeed(args),args);
+    return res;
+    }
+
+} //namespace itensor
+
+#endif
@@ -0,0 +1,48 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_METTS_MPI_H
+#define __ITENSOR_METTS_MPI_H
+
+#include "itensor/util/parallel.h"
+#include "itensor/mps/metts.h"
+
+namespace itensor {
+
+//
+// METTS sampling (see metts in metts.h) with the chains
+// divided over the nodes of env: chain c runs on node
+// c % env.nnodes(), using "NThread" threads on each node.
+// The seed is taken from node 0, so the results are the
+// same as those of metts on one node with the same "Seed".
+// Every node returns the results of all chains.
+//
+METTSResults inline
+metts(Environment const& env,
+      MPS const& psi0,
+      MPO const& expH,
+      int nstep,
+      std::vector<MPO> const& ops,
+      Args const& args = Args::global())
+    {
+    auto nchain = args.getInt("NChain",1);
+    if(nchain < 1) Error("NChain must be set >= 1");
+    auto seed = detail::randomSeed(args);
+    broadcast(env,seed);
+
+    auto res = METTSResults(nchain,ops.size());
+    auto chains = std::vector<long>{};
+    for(auto c = long(env.rank()); c < nchain; c += env.nnodes()) chains.push_back(c);
+    detail::runMETTSChains(chains,psi0,expH,nstep,ops,res,seed,args);
+
+    for(auto* v : {&res.counts(),&res.sums(),&res.sums2()})
+        {
+        MPI_Allreduce(MPI_IN_PLACE,v->data(),int(v->size()),MPI_DOUBLE,MPI_SUM,MPI_COMM_WORLD);
+        }
+    return res;
+    }
+
+} //namespace itensor
+
+#endif
@@ -275,6 +275,27 @@ overlapC(MPSt<Tensor> const& psi,
          MPOt<Tensor> const& K,
          MPSt<Tensor> const& phi);
 
+//
+// Energy variance <psi|H^2|psi>/<psi|psi> - (<psi|H|psi>/<psi|psi>)^2
+// computed without forming the MPO H^2.
+//
+// Arguments recognized:
+// o "Method":
+//   - (Default) "Exact" - contract <psi|H H|psi> with H on both
+//     sides of a single network (cost m^3 k^2 d + m^2 k^3 d^2
+//     for MPS bond dimension m and MPO bond dimension k)
+//   - "Fit" - compute |phi> = H|psi> using fitApplyMPO and
+//     use <psi|H^2|psi> = <phi|phi>
+//   - "ZipUp" - same, using zipUpApplyMPO
+// o "Maxm", "Cutoff", "Nsweep" - truncation of H|psi>
+//   (for "Fit" and "ZipUp")
+//
+template <class Tensor>
+Real
+variance(MPSt<Tensor> const& psi,
+         MPOt<Tensor> const& H,
+         Args const& args = Args::global());
+
 template<class MPOType>
 void 
 nmultMPO(MPOType const& Aorig, 
@@ -439,6 +460,32 @@ applyExpH(MPSt<Tensor> const& psi,
           MPSt<Tensor>& res, 
           Args const& args = Args::global());
 
+//
+//Computes |res> = exp(t*H)|psi> for complex t (for example
+//t = -i*dt for real-time evolution by dt) using a global
+//Krylov (Lanczos) method: the Krylov vectors H^k|psi> are
+//MPS, made with exactApplyMPO and orthogonalized by fitting
+//sums of MPS, and exp(t*H) is computed exactly in the small
+//space they span. Unlike applyExpH, whose Taylor series is
+//only accurate for small tau, the Krylov space adapts to
+//the step size, so much larger steps can be taken.
+//Returns an estimate of the error of |res> relative to
+//the norm of |psi>.
+//List of named arguments recognized:
+//   "MaxIter" : maximum number of Krylov vectors (default: 10)
+//   "ErrGoal" : stop once the error estimate is below this (default: 1E-10)
+//   "Cutoff"  : maximum truncation error of each MPS product or sum
+//   "Maxm"    : maximum number of states after truncation
+//   "Verbose" : print the error estimate after each iteration
+//
+template<class Tensor>
+Real
+applyExpKrylov(MPSt<Tensor> const& psi, 
+               MPOt<Tensor> const& H, 
+               Cplx t, 
+               MPSt<Tensor>& res, 
+               Args const& args = Args::global());
+
 //Given an MPO with no Link indices between site operators,
 //put in links (of bond dimension 1).
 //In the IQMPO case ensure that links carry the proper QNs.
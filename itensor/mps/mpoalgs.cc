@@ -5,6 +5,7 @@
 #include "itensor/util/print_macro.h"
 #include "itensor/mps/mpo.h"
 #include "itensor/mps/localop.h"
+#include "itensor/tensor/algs.h"
 
 namespace itensor {
 
@@ -173,6 +174,48 @@ template
 void 
 zipUpApplyMPO(const IQMPS& x, const IQMPO& K, IQMPS& res, const Args& args);
 
+template <class Tensor>
+Real
+variance(MPSt<Tensor> const& psi,
+         MPOt<Tensor> const& H,
+         Args const& args)
+    {
+    auto method = args.getString("Method","Exact");
+    auto nrm2 = overlapC(psi,psi).real();
+    auto E = overlapC(psi,H,psi).real()/nrm2;
+    Real H2 = 0;
+    if(method == "Exact")
+        {
+        H2 = overlapC(psi,H,H,psi).real();
+        }
+    else if(method == "Fit")
+        {
+        auto fargs = args;
+        fargs.add("Normalize",false);
+        auto phi = fitApplyMPO(psi,H,fargs);
+        H2 = overlapC(phi,phi).real();
+        }
+    else if(method == "ZipUp")
+        {
+        auto zargs = args;
+        zargs.add("AllowArbPosition",true);
+        auto psi1 = psi;
+        psi1.position(1);
+        MPSt<Tensor> phi;
+        zipUpApplyMPO(psi1,H,phi,zargs);
+        H2 = overlapC(phi,phi).real();
+        }
+    else
+        {
+        Error(format("variance: unknown Method \"%s\"",method));
+        }
+    return H2/nrm2-E*E;
+    }
+template
+Real variance(MPS const& psi, MPO const& H, Args const& args);
+template
+Real variance(IQMPS const& psi, IQMPO const& H, Args const& args);
+
 
 template<class Tensor>
 MPSt<Tensor>
@@ -788,6 +831,97 @@ template
 void
 applyExpH(const MPSt<IQTensor>& psi, const MPOt<IQTensor>& H, Real tau, MPSt<IQTensor>& res, const Args& args);
 
+template<class Tensor>
+Real
+applyExpKrylov(MPSt<Tensor> const& psi, 
+               MPOt<Tensor> const& H, 
+               Cplx t, 
+               MPSt<Tensor>& res, 
+               Args const& args)
+    {
+    using MPST = MPSt<Tensor>;
+
+    auto maxiter = args.getInt("MaxIter",10);
+    auto errgoal = args.getReal("ErrGoal",1E-10);
+    auto verbose = args.getBool("Verbose",false);
+    if(maxiter < 1) Error("applyExpKrylov: MaxIter must be >= 1");
+    auto pargs = args;
+    pargs.add("Verbose",false);
+
+    //z*M, keeping M real if z is real
+    auto scaled = [](Cplx z, MPST M)
+        {
+        if(z.imag() == 0.) M *= z.real();
+        else               M *= z;
+        return M;
+        };
+
+    auto V = vector<MPST>{psi};
+    V[0].position(1);
+    auto nrm = norm(V[0]);
+    if(nrm == 0.) Error("applyExpKrylov: psi has zero norm");
+    V[0] /= nrm;
+
+    //h(j,k) = <V_j|H|V_k>, computed exactly rather than from
+    //the truncated products so that it stays Hermitian
+    auto h = CMatrix(maxiter,maxiter);
+    auto c = CVector{};
+    Real err = NAN;
+    for(auto k : range(maxiter))
+        {
+        auto w = exactApplyMPO(H,V[k],pargs);
+        for(auto j : range(k+1))
+            {
+            h(j,k) = overlapC(V[j],H,V[k]);
+            h(k,j) = std::conj(h(j,k));
+            }
+        h(k,k) = h(k,k).real();
+
+        //Orthogonalize w against the Krylov vectors
+        auto terms = vector<MPST>{w};
+        for(auto& v : V) terms.push_back(scaled(-overlapC(v,w),v));
+        w = sum(terms,pargs);
+        w.position(1);
+        auto b = norm(w);
+
+        //exp(t*h) e_0 in the Krylov space
+        auto n = k+1;
+        auto hk = CMatrix(n,n);
+        for(auto i : range(n))
+        for(auto j : range(n))
+            {
+            hk(i,j) = h(i,j);
+            }
+        CMatrix U;
+        Vector d;
+        diagHermitian(hk,U,d);
+        c = CVector(n);
+        for(auto j : range(n))
+        for(auto l : range(n))
+            {
+            c(j) += U(j,l)*std::exp(t*d(l))*std::conj(U(0,l));
+            }
+
+        err = b*std::abs(c(n-1));
+        if(verbose) printfln("applyExpKrylov: iter %d, error estimate %.3E, max m %d",n,err,maxM(w));
+        if(err < errgoal || b < 1E-14 || n == maxiter) break;
+
+        w /= b;
+        V.push_back(std::move(w));
+        }
+
+    auto terms = vector<MPST>{};
+    for(auto j : range(c.size())) terms.push_back(scaled(nrm*c(j),V[j]));
+    res = sum(terms,pargs);
+    return err;
+    }
+template
+Real
+applyExpKrylov(MPSt<ITensor> const& psi, MPOt<ITensor> const& H, Cplx t, MPSt<ITensor>& res, Args const& args);
+template
+Real
+applyExpKrylov(MPSt<IQTensor> const& psi, MPOt<IQTensor> const& H, Cplx t, MPSt<IQTensor>& res, Args const& args);
+
 
 
 } //namespace itensor
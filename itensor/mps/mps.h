@@ -380,6 +380,23 @@ template <typename MPST>
 int
 maxM(MPST const& psi);
 
+//
+// Schmidt spectra of psi at every bond, found in a single
+// sweep from left to right. Entry b of the result (b = 1,...,N-1)
+// holds the eigenvalues of the reduced density matrix of
+// sites 1,...,b (and their QNs for an IQMPS), normalized
+// so that they sum to 1; entry 0 is unused. Use entropy(spec)
+// and qnWeights(spec) to obtain entropies and sector weights.
+//
+// Arguments recognized:
+// o "Maxm" - only keep the Maxm largest eigenvalues of each
+//   spectrum (the rest is reported as spec.truncerr())
+//
+template<typename T>
+std::vector<Spectrum>
+bondSpectra(MPSt<T> psi,
+            Args const& args = Args::global());
+
 //
 // Applies a bond gate to the bond that is currently
 // the OC.                                    |      |
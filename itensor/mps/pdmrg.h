@@ -0,0 +1,311 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_PDMRG_H
+#define __ITENSOR_PDMRG_H
+
+#include <limits>
+#include <memory>
+#include "itensor/mps/localmpo_mpi.h"
+
+namespace itensor {
+
+//
+// Real-space parallel DMRG (E.M. Stoudenmire and S.R. White,
+// Phys. Rev. B 87, 155137 (2013)) over the nodes of env.
+//
+// The sites are split into env.nnodes() contiguous blocks,
+// and node n holds the MPS tensors and LocalMPO environment
+// tensors of block n. Between neighboring blocks the MPS is
+// kept in the form psi = ... A_b Lambda_b Lambda_b^-1 Lambda_b B_b+1 ...,
+// each block owning one factor Lambda_b and the node to its left
+// holding the inverse singular values V_b = Lambda_b^-1.
+// In each half sweep every node sweeps its block (even nodes
+// right then left, odd nodes left then right), and neighbors
+// arriving at their shared boundary together optimize the two
+// sites there: the right node sends its boundary tensor and
+// environment through a MailBox, the left node optimizes
+// psi.A(b)*V_b*psi.A(b+1), and sends back the new tensor
+// for site b+1 and the environment of sites 1,...,b.
+//
+// The tensors of psi and H are taken from node 0, so psi must
+// have the same SiteSet on every node (such as one made on node 0
+// and broadcast to the others). On return, every node holds the
+// optimized psi (gathered from the blocks) and the returned
+// energy <psi|H|psi>.
+//
+// Requires psi.N() >= 2*env.nnodes() and two-site sweeps
+// (sweeps.numCenter(sw) == 2); sweeps.noise(sw) is not used
+// for the bonds between blocks.
+//
+// Arguments recognized:
+// o "Quiet" (default: false) - suppress output
+// o "InvCutoff" (default: 1E-8) - singular values below InvCutoff
+//   are replaced by InvCutoff when computing V_b
+// o Arguments of davidson and LocalMPO, such as "NThread"
+//
+template <class Tensor>
+Real
+parallelDMRG(Environment const& env,
+             MPSt<Tensor>& psi,
+             MPOt<Tensor> H,
+             Sweeps const& sweeps,
+             Args args = Args::global());
+
+
+
+namespace detail {
+
+//Extend the edge tensor E (null at the ends) of
+//<psi|H|psi> by the site tensor A and MPO tensor W
+template <class Tensor>
+Tensor
+extendEdge(Tensor const& E, Tensor const& A, Tensor const& W)
+    {
+    auto R = E ? E*A : A;
+    R *= W;
+    R *= dag(prime(A));
+    return R;
+    }
+
+//Inverse V of the singular values S, such that
+//(U*S)*V*(S*V') = U*S*V' for the svd U*S*V' of a tensor
+template <class Tensor>
+Tensor
+inverseSingular(Tensor S, Real cut)
+    {
+    S.apply([cut](Real s) { return 1./std::max(s,cut); });
+    return dag(S);
+    }
+
+//First site of block n of N sites split into nblock blocks
+int inline
+blockStart(int n, int N, int nblock) { return 1+long(n)*N/nblock; }
+
+//
+// Brings psi (on node 0) to the form used by parallelDMRG:
+// for the last site c of each block n but the last, psi.A(c)
+// is U*S and psi.A(c+1) starts with S, for the svd U*S*V'
+// of the bond between blocks, and V[n] is the inverse of S.
+// Also computes the edge tensors L[n] of the sites left of
+// block n and R[n] of the sites right of block n, each built
+// from the orthonormal (Schmidt) basis at that bond.
+//
+template <class Tensor>
+void
+splitBlocks(MPSt<Tensor>& psi,
+            MPOt<Tensor> const& H,
+            int nblock,
+            std::vector<Tensor>& V,
+            std::vector<Tensor>& L,
+            std::vector<Tensor>& R,
+            Args const& args)
+    {
+    using IndexT = typename Tensor::index_type;
+    auto N = psi.N();
+    auto invcut = args.getReal("InvCutoff",1E-8);
+    V.assign(nblock,Tensor());
+    L.assign(nblock,Tensor());
+    R.assign(nblock,Tensor());
+
+    psi.position(1);
+    //Edge tensors of sites j,...,N in the right-orthogonal gauge
+    auto RB = std::vector<Tensor>(N+2);
+    for(auto j = N; j > 1; --j) RB[j] = extendEdge(RB[j+1],psi.A(j),H.A(j));
+
+    auto E = Tensor();
+    auto elim = 0;
+    for(auto n : range(nblock-1))
+        {
+        auto c = blockStart(n+1,N,nblock)-1;
+        psi.position(c);
+        for(auto j : range1(elim+1,c-1)) E = extendEdge(E,psi.A(j),H.A(j));
+        auto l = commonIndex(psi.A(c),psi.A(c+1),Link);
+        auto uinds = std::vector<IndexT>{};
+        for(auto& I : psi.A(c).inds()) if(I != l) uinds.push_back(I);
+        auto U = Tensor(IndexSetT<IndexT>(std::move(uinds)));
+        Tensor S,W;
+        svd(psi.A(c),U,S,W,{"Truncate",false});
+        E = extendEdge(E,U,H.A(c));
+        elim = c;
+        L.at(n+1) = E;
+        R.at(n) = extendEdge(RB[c+2],W*psi.A(c+1),H.A(c+1));
+        V.at(n) = inverseSingular(S,invcut);
+        psi.setA(c,U*S);
+        psi.setA(c+1,S*W*psi.A(c+1));
+        psi.leftLim(c);
+        psi.rightLim(c+2);
+        }
+    }
+
+} //namespace detail
+
+template <class Tensor>
+Real
+parallelDMRG(Environment const& env,
+             MPSt<Tensor>& psi,
+             MPOt<Tensor> H,
+             Sweeps const& sweeps,
+             Args args)
+    {
+    using IndexT = typename Tensor::index_type;
+    auto quiet = args.getBool("Quiet",false);
+    auto invcut = args.getReal("InvCutoff",1E-8);
+    auto nn = env.nnodes();
+    auto node = env.rank();
+
+    if(nn == 1) return dmrg(psi,H,sweeps,args);
+
+    auto N = psi.N();
+    if(H.N() != N) Error("parallelDMRG: mismatched N of psi and H");
+    if(N < 2*nn) Error("parallelDMRG: psi must have at least 2 sites per node");
+
+    args.add("DebugLevel",args.getInt("DebugLevel",0));
+    args.add("DoNormalize",true);
+
+    auto V = std::vector<Tensor>{},
+         L = std::vector<Tensor>{},
+         R = std::vector<Tensor>{};
+    if(env.firstNode()) detail::splitBlocks(psi,H,nn,V,L,R,args);
+    detail::broadcastTensors(env,psi);
+    detail::broadcastTensors(env,H);
+    broadcast(env,V,L,R);
+
+    //This node's block of sites b1,...,b2
+    auto b1 = detail::blockStart(node,N,nn),
+         b2 = detail::blockStart(node+1,N,nn)-1;
+    auto Vb = V.at(node);
+    auto PH = LocalMPO<Tensor>(H,L.at(node),b1-1,R.at(node),b2+1,args);
+    L.clear();
+    R.clear();
+    V.clear();
+
+    //Move the center of the block to the side it is
+    //first swept from: the left for even nodes
+    if(env.lastNode()) { psi.leftLim(b1-1); psi.rightLim(b1+1); }
+    else               { psi.leftLim(b2-1); psi.rightLim(b2+1); }
+    psi.position(node%2 == 0 ? b1 : b2);
+
+    auto lbox = std::unique_ptr<MailBox>(node > 0 ? new MailBox(env,node-1) : nullptr);
+    auto rbox = std::unique_ptr<MailBox>(env.lastNode() ? nullptr : new MailBox(env,node+1));
+
+    for(int sw = 1; sw <= sweeps.nsweep(); ++sw)
+        {
+        cpu_time sw_time;
+        if(sweeps.numCenter(sw) != 2) Error("parallelDMRG: numCenter must be 2");
+        args.add("Sweep",sw);
+        args.add("Cutoff",sweeps.cutoff(sw));
+        args.add("Minm",sweeps.minm(sw));
+        args.add("Maxm",sweeps.maxm(sw));
+        args.add("Noise",sweeps.noise(sw));
+        args.add("MaxIter",sweeps.niter(sw));
+
+        auto energy = std::numeric_limits<Real>::max();
+        for(int ha = 1; ha <= 2; ++ha)
+            {
+            if((node+ha)%2 == 1)
+                {
+                //Sweep right, then optimize the
+                //boundary with the right neighbor
+                for(auto b : range1(b1,b2-1))
+                    {
+                    PH.position(b,psi);
+                    auto phi = psi.A(b)*psi.A(b+1);
+                    energy = davidson(PH,phi,args);
+                    psi.svdBond(b,phi,Fromleft,PH,args);
+                    }
+                if(!rbox) continue;
+
+                auto D = rbox->template receive<Tensor>();
+                auto RE = rbox->template receive<Tensor>();
+                PH.R(b2+1,RE);
+                PH.position(b2,psi);
+                auto phi = psi.A(b2)*Vb*D;
+                energy = davidson(PH,phi,args);
+                phi /= norm(phi);
+
+                auto v = commonIndex(psi.A(b2),Vb);
+                auto uinds = std::vector<IndexT>{};
+                for(auto& I : psi.A(b2).inds()) if(I != v) uinds.push_back(I);
+                auto U = Tensor(IndexSetT<IndexT>(std::move(uinds)));
+                Tensor S,W;
+                svd(phi,U,S,W,args);
+                Vb = detail::inverseSingular(S,invcut);
+                rbox->send(S*W);
+                rbox->send(detail::extendEdge(PH.L(),U,H.A(b2)));
+                psi.setA(b2,U*S);
+                psi.setA(b2+1,W);
+                psi.leftLim(b2-1);
+                psi.rightLim(b2+1);
+                }
+            else
+                {
+                //Sweep left, then let the left neighbor
+                //optimize the boundary
+                for(auto b = b2-1; b >= b1; --b)
+                    {
+                    PH.position(b,psi);
+                    auto phi = psi.A(b)*psi.A(b+1);
+                    energy = davidson(PH,phi,args);
+                    psi.svdBond(b,phi,Fromright,PH,args);
+                    }
+                if(!lbox) continue;
+
+                lbox->send(psi.A(b1));
+                lbox->send(detail::extendEdge(PH.R(),psi.A(b1+1),H.A(b1+1)));
+                auto D = lbox->template receive<Tensor>();
+                auto LE = lbox->template receive<Tensor>();
+                psi.setA(b1,D);
+                psi.leftLim(b1-1);
+                psi.rightLim(b1+1);
+                PH.L(b1,LE);
+                }
+            }
+
+        MPI_Allreduce(MPI_IN_PLACE,&energy,1,MPI_DOUBLE,MPI_MIN,MPI_COMM_WORLD);
+        if(!quiet && env.firstNode())
+            {
+            auto sm = sw_time.sincemark();
+            printfln("    Sweep %d/%d: energy = %.14f, CPU time = %s (Wall time = %s)",
+                     sw,sweeps.nsweep(),energy,showtime(sm.time),showtime(sm.wall));
+            }
+        }
+
+    //Gather the blocks on node 0, multiplying
+    //each V_b into the last site of its block
+    if(Vb) psi.Aref(b2) *= Vb;
+    if(env.firstNode())
+        {
+        auto block = std::vector<Tensor>{};
+        for(auto n : range1(nn-1))
+            {
+            MailBox box(env,n);
+            box.receive(block);
+            auto j = detail::blockStart(n,N,nn);
+            for(auto& A : block) psi.Aref(j++) = std::move(A);
+            }
+        psi.leftLim(0);
+        psi.rightLim(N+1);
+        psi.position(1);
+        psi.normalize();
+        }
+    else
+        {
+        auto block = std::vector<Tensor>{};
+        for(auto j : range1(b1,b2)) block.push_back(psi.A(j));
+        MailBox box(env,0);
+        box.send(block);
+        }
+    detail::broadcastTensors(env,psi);
+    psi.leftLim(0);
+    psi.rightLim(2);
+
+    auto energy = overlap(psi,H,psi);
+    if(!quiet && env.firstNode()) printfln("    parallelDMRG: energy = %.14f",energy);
+    return energy;
+    }
+
+} //namespace itensor
+
+#endif
@@ -0,0 +1,240 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_SAMPLING_H
+#define __ITENSOR_SAMPLING_H
+
+#include <random>
+#include "itensor/mps/mps.h"
+#include "itensor/util/threadpool.h"
+
+namespace itensor {
+
+//
+// MPSSampler draws configurations (product states of the
+// site basis states) with the probabilities |<config|psi>|^2
+// of a normalized MPS psi.
+//
+// psi is right-orthogonalized once, when the sampler is made,
+// and its tensors are stored as dense matrices. A batch of
+// samples is then drawn site by site from left to right: the
+// states of all samples of the batch at site j are drawn from
+// one matrix product (of the conditional left vectors of the
+// samples times the matrix of site j), so each site costs one
+// gemm per batch rather than a contraction per sample.
+//
+// A configuration is returned as a vector c with c[j] the
+// number (1,...,m) of the state of site j, and c[0] unused.
+//
+template <class MPSType>
+class MPSSampler
+    {
+    int N_ = 0;
+    bool cplx_ = false;
+    //d_[j] is the dimension of site j, and M_[j] (CM_[j] if
+    //psi is complex) site j as a matrix with a row for each
+    //value a of its left link and column s+d_[j]*b for site
+    //state s (from 0) and value b of its right link
+    std::vector<long> d_;
+    std::vector<Matrix> M_;
+    std::vector<CMatrix> CM_;
+
+    public:
+
+    MPSSampler() { }
+
+    explicit
+    MPSSampler(MPSType psi);
+
+    int
+    N() const { return N_; }
+
+    //Draw nsample configurations using the random number
+    //generator rng, in batches of "BatchSize" (default: 64)
+    template <class RNG>
+    std::vector<std::vector<int>>
+    sample(long nsample,
+           RNG & rng,
+           Args const& args = Args::global()) const;
+
+    //Draw nsample configurations in batches of "BatchSize"
+    //(default: 64) using "NThread" (default: 1) threads. Batch
+    //k uses its own random number generator, seeded from "Seed"
+    //(default: random) and k, so the configurations drawn do
+    //not depend on the number of threads.
+    std::vector<std::vector<int>>
+    sample(long nsample,
+           Args const& args = Args::global()) const;
+
+    explicit operator bool() const { return N_ > 0; }
+
+    private:
+
+    template <typename V, class RNG>
+    void
+    sampleBatch(std::vector<Mat<V>> const& M,
+                std::vector<int>* conf,
+                long nb,
+                RNG & rng) const;
+    };
+
+//Draw nsample configurations of psi (see MPSSampler)
+template <class MPSType>
+std::vector<std::vector<int>>
+sample(MPSType const& psi,
+       long nsample,
+       Args const& args = Args::global())
+    {
+    return MPSSampler<MPSType>(psi).sample(nsample,args);
+    }
+
+
+namespace detail {
+
+//"Seed" if defined, otherwise a random seed
+int inline
+randomSeed(Args const& args)
+    {
+    if(args.defined("Seed")) return args.getInt("Seed");
+    return int(std::random_device{}() >> 1);
+    }
+
+ITensor inline
+denseSite(ITensor const& T) { return T; }
+
+ITensor inline
+denseSite(IQTensor const& T) { return toITensor(T); }
+
+} //namespace detail
+
+template <class MPSType>
+MPSSampler<MPSType>::
+MPSSampler(MPSType psi)
+  : N_(psi.N()),
+    d_(psi.N()+1,0),
+    M_(psi.N()+1),
+    CM_(psi.N()+1)
+    {
+    psi.position(1);
+    psi.Aref(1) /= norm(psi.A(1));
+
+    for(auto j : range1(N_)) cplx_ = cplx_ || isComplex(psi.A(j));
+
+    for(auto j : range1(N_))
+        {
+        //Give the end sites a left or right link of dimension 1
+        auto T = detail::denseSite(psi.A(j));
+        auto s = Index(findtype(psi.A(j),Site));
+        auto l = (j > 1) ? Index(commonIndex(psi.A(j-1),psi.A(j),Link)) : Index("l",1,Link);
+        auto r = (j < N_) ? Index(commonIndex(psi.A(j),psi.A(j+1),Link)) : Index("r",1,Link);
+        if(j == 1) T *= setElt(l(1));
+        if(j == N_) T *= setElt(r(1));
+        auto ml = l.m(),
+             mr = r.m(),
+             d = s.m();
+        d_[j] = d;
+        if(cplx_) CM_[j] = CMatrix(ml,d*mr);
+        else      M_[j] = Matrix(ml,d*mr);
+        for(auto a : range(ml))
+        for(auto b : range(mr))
+        for(auto k : range(d))
+            {
+            if(cplx_) CM_[j](a,k+d*b) = T.cplx(s(1+k),l(1+a),r(1+b));
+            else      M_[j](a,k+d*b) = T.real(s(1+k),l(1+a),r(1+b));
+            }
+        }
+    }
+
+template <class MPSType>
+template <typename V, class RNG>
+void MPSSampler<MPSType>::
+sampleBatch(std::vector<Mat<V>> const& M,
+            std::vector<int>* conf,
+            long nb,
+            RNG & rng) const
+    {
+    auto dist = std::uniform_real_distribution<Real>(0.,1.);
+    //Row n of L is the left vector of sample n given
+    //its states on the sites to the left, with norm 1
+    auto L = Mat<V>(nb,1);
+    for(auto n : range(nb)) L(n,0) = 1.;
+    auto p = std::vector<Real>{};
+    for(auto j : range1(N_))
+        {
+        auto d = d_[j];
+        auto mr = ncols(M[j])/d;
+        auto W = L*M[j];
+        L = Mat<V>(nb,mr);
+        p.resize(d);
+        for(auto n : range(nb))
+            {
+            //Probabilities of the states of site j: psi is
+            //right-orthogonal, so the right links just sum
+            auto tot = 0.;
+            for(auto k : range(d))
+                {
+                p[k] = 0.;
+                for(auto b : range(mr)) p[k] += std::norm(W(n,k+d*b));
+                tot += p[k];
+                }
+            auto x = tot*dist(rng);
+            auto k = 0L;
+            for(auto acc = p[0]; x > acc && k+1 < d; acc += p[k]) ++k;
+            conf[n][j] = 1+k;
+            auto f = 1./std::sqrt(p[k]);
+            for(auto b : range(mr)) L(n,b) = f*W(n,k+d*b);
+            }
+        }
+    }
+
+template <class MPSType>
+template <class RNG>
+std::vector<std::vector<int>> MPSSampler<MPSType>::
+sample(long nsample,
+       RNG & rng,
+       Args const& args) const
+    {
+    auto bsize = args.getInt("BatchSize",64);
+    if(bsize < 1) Error("BatchSize must be set >= 1");
+    auto res = std::vector<std::vector<int>>(nsample,std::vector<int>(N_+1,0));
+    for(auto n = 0L; n < nsample; n += bsize)
+        {
+        auto nb = std::min(long(bsize),nsample-n);
+        if(cplx_) sampleBatch(CM_,res.data()+n,nb,rng);
+        else      sampleBatch(M_,res.data()+n,nb,rng);
+        }
+    return res;
+    }
+
+template <class MPSType>
+std::vector<std::vector<int>> MPSSampler<MPSType>::
+sample(long nsample,
+       Args const& args) const
+    {
+    auto bsize = args.getInt("BatchSize",64);
+    if(bsize < 1) Error("BatchSize must be set >= 1");
+    auto nthread = args.getInt("NThread",1);
+    if(nthread < 1) Error("NThread must be set >= 1");
+    auto seed = detail::randomSeed(args);
+
+    auto res = std::vector<std::vector<int>>(nsample,std::vector<int>(N_+1,0));
+    auto nbatch = (nsample+bsize-1)/bsize;
+    auto nt = std::min(long(nthread),nbatch);
+    detail::parallelFor(nt,[&](size_t t)
+        {
+        for(auto k = long(t); k < nbatch; k += nt)
+            {
+            std::seed_seq sq{seed,int(k)};
+            auto rng = std::mt19937(sq);
+            auto nb = std::min(long(bsize),nsample-k*bsize);
+            if(cplx_) sampleBatch(CM_,res.data()+k*bsize,nb,rng);
+            else      sampleBatch(M_,res.data()+k*bsize,nb,rng);
+            }
+        });
+    return res;
+    }
+
+} //namespace itensor
+
+#endif
@@ -0,0 +1,215 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_SHAREDTENSORS_H
+#define __ITENSOR_SHAREDTENSORS_H
+
+#include <algorithm>
+#include <set>
+#include "itensor/mps/mpo.h"
+
+namespace itensor {
+
+//
+// Tensor with the data of T and the indices of T
+// with from[n] replaced by to[n]. The storage of T
+// is shared, not copied: the two tensors use the same
+// memory until one of them is modified (storage is
+// copy-on-write). Each to[n] must have the same size
+// (and, for IQIndex, the same arrow and blocks) as from[n].
+//
+template<typename Tensor>
+Tensor
+relabelShared(Tensor T,
+              std::vector<typename Tensor::index_type> const& from,
+              std::vector<typename Tensor::index_type> const& to);
+
+//
+// Makes the tensors of an MPS or MPO which equal
+// another site's tensor up to relabeling their site
+// and link indices share storage with that tensor
+// (a "prototype"). For a translation-invariant MPO,
+// such as a uniform Hamiltonian made by AutoMPO,
+// this reduces its memory from O(N) tensors to the
+// number of distinct tensors in a unit cell, and the
+// same memory is reused at every site of a sweep.
+//
+// The MPS or MPO is unchanged otherwise, and modifying
+// one of the tensors later only copies that tensor.
+//
+// Returns the number of distinct tensors afterward.
+//
+// Arguments recognized:
+// o "Cutoff" (default: 1E-12) - tensors are considered
+//   equal if their difference has norm below Cutoff
+//   times their norm
+// o "Period" (default: 0) - if > 0, only compare site j
+//   with site j-Period (such as for a unit cell of Period
+//   sites); otherwise compare with every prototype found
+//
+template<typename MPSType>
+int
+shareTensors(MPSType & psi,
+             Args const& args = Args::global());
+
+//
+// Number of distinct tensors (storage) held
+// by the sites 1,...,N of an MPS or MPO
+//
+template<typename MPSType>
+int
+numDistinctTensors(MPSType const& psi);
+
+
+
+template<typename Tensor>
+Tensor
+relabelShared(Tensor T,
+              std::vector<typename Tensor::index_type> const& from,
+              std::vector<typename Tensor::index_type> const& to)
+    {
+    using IndexT = typename Tensor::index_type;
+    if(from.size() != to.size()) Error("relabelShared: from and to must have the same size");
+    auto inds = std::vector<IndexT>{};
+    inds.reserve(rank(T));
+    for(auto& I : T.inds())
+        {
+        auto n = std::find(from.begin(),from.end(),I)-from.begin();
+        if(size_t(n) == from.size())
+            {
+            inds.push_back(I);
+            continue;
+            }
+        if(to[n].m() != I.m()) Error("relabelShared: index sizes must match");
+        inds.push_back(to[n]);
+        }
+    auto scale = T.scale();
+    return Tensor(IndexSetT<IndexT>(std::move(inds)),std::move(T.store()),scale);
+    }
+
+namespace detail {
+
+bool inline
+sameShape(Index const& i, Index const& j)
+    {
+    return i.m() == j.m() && i.primeLevel() == j.primeLevel();
+    }
+
+bool inline
+sameShape(IQIndex const& i, IQIndex const& j)
+    {
+    if(i.m() != j.m() || i.primeLevel() != j.primeLevel()) return false;
+    if(i.dir() != j.dir() || i.nindex() != j.nindex()) return false;
+    for(auto n : range1(i.nindex()))
+        {
+        if(i.index(n).m() != j.index(n).m() || i.qn(n) != j.qn(n)) return false;
+        }
+    return true;
+    }
+
+bool inline
+sameDiv(ITensor const& A, ITensor const& B) { return true; }
+
+bool inline
+sameDiv(IQTensor const& A, IQTensor const& B) { return div(A) == div(B); }
+
+//Indices of site j of psi by their role: left
+//link, right link (null at the ends), then
+//site indices by increasing prime level.
+//Returns an empty vector if site j has other indices.
+template<typename MPSType>
+std::vector<typename MPSType::IndexT>
+siteRoles(MPSType const& psi, int j)
+    {
+    using IndexT = typename MPSType::IndexT;
+    auto& T = psi.A(j);
+    auto res = std::vector<IndexT>(2);
+    if(j > 1) res[0] = commonIndex(T,psi.A(j-1),Link);
+    if(j < psi.N()) res[1] = commonIndex(T,psi.A(j+1),Link);
+    auto s = std::vector<IndexT>{};
+    for(auto& I : T.inds()) if(I.type() == Site) s.push_back(I);
+    std::sort(s.begin(),s.end(),
+              [](IndexT const& a, IndexT const& b) { return a.primeLevel() < b.primeLevel(); });
+    res.insert(res.end(),s.begin(),s.end());
+    auto nind = long(s.size()) + (res[0] ? 1 : 0) + (res[1] ? 1 : 0);
+    if(nind != rank(T)) return {};
+    return res;
+    }
+
+//Tensor at site j of psi made by relabeling the tensor
+//at site p, if they are equal up to the given cutoff;
+//otherwise a null tensor
+template<typename MPSType>
+typename MPSType::TensorT
+matchSite(MPSType const& psi,
+          int p,
+          int j,
+          Real cutoff)
+    {
+    using TensorT = typename MPSType::TensorT;
+    auto from = siteRoles(psi,p),
+         to = siteRoles(psi,j);
+    if(from.empty() || from.size() != to.size()) return TensorT();
+    for(auto n : range(from.size()))
+        {
+        if(bool(from[n]) != bool(to[n])) return TensorT();
+        if(from[n] && !sameShape(from[n],to[n])) return TensorT();
+        }
+    auto& W = psi.A(j);
+    auto R = relabelShared(psi.A(p),from,to);
+    if(!sameDiv(R,W)) return TensorT();
+    if(norm(W-R) > cutoff*norm(W)) return TensorT();
+    return R;
+    }
+
+} //namespace detail
+
+template<typename MPSType>
+int
+shareTensors(MPSType & psi,
+             Args const& args)
+    {
+    if(psi.doWrite()) Error("shareTensors: MPS or MPO must be in memory (doWrite false)");
+    auto cutoff = args.getReal("Cutoff",1E-12);
+    auto period = int(args.getInt("Period",0));
+    auto N = psi.N();
+    auto llim = psi.leftLim(),
+         rlim = psi.rightLim();
+    auto protos = std::vector<int>{};
+    for(auto j : range1(N))
+        {
+        auto found = false;
+        auto candidates = (period > 0) ? std::vector<int>{j-period} : protos;
+        for(auto p : candidates)
+            {
+            if(p < 1) continue;
+            auto R = detail::matchSite(psi,p,j,cutoff);
+            if(!R) continue;
+            psi.Aref(j) = std::move(R);
+            found = true;
+            break;
+            }
+        if(!found) protos.push_back(j);
+        }
+    psi.leftLim(llim);
+    psi.rightLim(rlim);
+    return numDistinctTensors(psi);
+    }
+
+template<typename MPSType>
+int
+numDistinctTensors(MPSType const& psi)
+    {
+    auto stores = std::set<void const*>{};
+    for(auto j : range1(psi.N()))
+        {
+        auto T = psi.A(j);
+        if(T) stores.insert(T.store().get());
+        }
+    return int(stores.size());
+    }
+
+} //namespace itensor
+
+#endif
@@ -0,0 +1,241 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_SPARSEMPO_H
+#define __ITENSOR_SPARSEMPO_H
+#include "itensor/mps/mpo.h"
+
+namespace itensor {
+
+template<class Tensor>
+class SparseMPOt;
+
+using SparseMPO = SparseMPOt<ITensor>;
+using SparseIQMPO = SparseMPOt<IQTensor>;
+
+//
+// Non-zero entry W(row,col) of an MPO site tensor,
+// viewed as a matrix of local operators indexed
+// by the left (row) and right (col) MPO link indices.
+//
+// Identity entries store only their coefficient
+// so that applying them amounts to relabeling
+// (priming) the site index of the tensor acted on.
+//
+template<class Tensor>
+struct SparseMPOElem
+    {
+    long row = 0;
+    long col = 0;
+    bool isId = false;
+    Cplx coef = 1.;
+    Tensor op;
+
+    SparseMPOElem() { }
+
+    SparseMPOElem(long r, long c, Tensor const& o)
+        : row(r), col(c), op(o) { }
+
+    SparseMPOElem(long r, long c, Cplx z)
+        : row(r), col(c), isId(true), coef(z) { }
+    };
+
+//
+// class SparseMPOt
+//
+// (defines SparseMPO and SparseIQMPO via above typedefs)
+//
+// Operator-valued matrix representation of an MPO.
+// Each site j stores only the non-zero operator
+// entries of the MPO tensor W_j; rows (columns)
+// label the values of the link index to the left
+// (right) of site j, numbered from 0. The first (last)
+// site has a single row (column).
+//
+// Typically constructed from an MPO made by AutoMPO,
+// whose tensors are mostly zeros and identities:
+//
+//   auto H = IQMPO(ampo);
+//   auto sH = SparseIQMPO(H);
+//
+// Use with LocalSparseMPO (or dmrg) to compute H|phi>
+// and the environment tensors by skipping zero entries.
+//
+// Named arguments recognized:
+//  "Cutoff" - entries with norm below this value
+//             are dropped (default: 1E-14)
+//
+template<class Tensor>
+class SparseMPOt
+    {
+    public:
+    using IndexT = typename Tensor::index_type;
+    using Elem = SparseMPOElem<Tensor>;
+    private:
+    int N_ = 0;
+    SiteSet sites_;
+    std::vector<std::vector<Elem>> elems_;
+    std::vector<long> rows_,
+                      cols_;
+    std::vector<IndexT> site_;
+    public:
+
+    SparseMPOt() { }
+
+    explicit
+    SparseMPOt(MPOt<Tensor> const& H,
+               Args const& args = Args::global());
+
+    int
+    N() const { return N_; }
+
+    explicit operator bool() const { return N_ > 0; }
+
+    SiteSet const&
+    sites() const
+        {
+        if(!sites_) Error("SparseMPO SiteSet is default-initialized");
+        return sites_;
+        }
+
+    //Non-zero entries of site j
+    std::vector<Elem> const&
+    elems(int j) const { return elems_.at(j); }
+
+    //Number of rows (left link values) of site j
+    long
+    rows(int j) const { return rows_.at(j); }
+
+    //Number of columns (right link values) of site j
+    long
+    cols(int j) const { return cols_.at(j); }
+
+    //Unprimed site index of site j
+    IndexT const&
+    site(int j) const { return site_.at(j); }
+
+    //Number of non-zero (identity) entries of site j
+    long
+    numNonZero(int j) const { return long(elems(j).size()); }
+    long
+    numIdentity(int j) const;
+    };
+
+template<class Tensor>
+SparseMPOt<Tensor>::
+SparseMPOt(MPOt<Tensor> const& H,
+           Args const& args)
+    : N_(H.N()),
+      sites_(H.sites()),
+      elems_(H.N()+1),
+      rows_(H.N()+1,1),
+      cols_(H.N()+1,1),
+      site_(H.N()+1)
+    {
+    auto cutoff = args.getReal("Cutoff",1E-14);
+    for(auto j : range1(N_))
+        {
+        auto& W = H.A(j);
+        auto s = noprime(findtype(W,Site));
+        site_[j] = s;
+        auto hl = (j > 1)  ? commonIndex(W,H.A(j-1),Link) : IndexT();
+        auto hr = (j < N_) ? commonIndex(W,H.A(j+1),Link) : IndexT();
+        if(hl) rows_[j] = hl.m();
+        if(hr) cols_[j] = hr.m();
+
+        //Contracting with tr gives the trace of an on-site operator
+        auto sinds = std::vector<IndexT>{};
+        for(auto& I : W.inds()) if(I.type() == Site) sinds.push_back(dag(I));
+        if(sinds.size() != 2) Error("SparseMPO: MPO tensor must have two site indices");
+        auto tr = delta(sinds.front(),sinds.back());
+        auto d = Real(s.m());
+
+        for(auto r : range(rows_[j]))
+            {
+            auto Wr = hl ? W*setElt(dag(hl)(1+r)) : W;
+            if(norm(Wr) <= cutoff) continue;
+            for(auto c : range(cols_[j]))
+                {
+                auto op = hr ? Wr*setElt(dag(hr)(1+c)) : Wr;
+                auto nrm = norm(op);
+                if(nrm <= cutoff) continue;
+                //op is proportional to the identity exactly
+                //when |tr(op)|^2 = d*|op|^2 (Cauchy-Schwarz)
+                auto z = (op*tr).cplx();
+                if(std::fabs(std::norm(z)/d-nrm*nrm) <= cutoff*nrm*nrm)
+                    {
+                    elems_[j].emplace_back(r,c,z/d);
+                    }
+                else
+                    {
+                    elems_[j].emplace_back(r,c,op);
+                    }
+                }
+            }
+        }
+    }
+
+template<class Tensor>
+long SparseMPOt<Tensor>::
+numIdentity(int j) const
+    {
+    long n = 0;
+    for(auto& e : elems(j)) if(e.isId) ++n;
+    return n;
+    }
+
+namespace detail {
+
+//Multiply T by the scalar z, keeping
+//T real when z is real and skipping z == 1
+template<class Tensor>
+void
+scaleBy(Tensor & T, Cplx z)
+    {
+    if(z.imag() != 0)    T *= z;
+    else if(z.real() != 1) T *= z.real();
+    }
+
+//True if T is null or, for an IQTensor, has
+//no blocks (such as when an operator maps
+//a state into a sector it has no overlap with)
+inline bool
+isZero(ITensor const& T) { return !T; }
+
+inline bool
+isZero(IQTensor const& T) { return !T || isEmpty(T); }
+
+//Accumulate T into S; S is null if nothing
+//has been added yet
+template<class Tensor>
+void
+addTo(Tensor & S, Tensor const& T)
+    {
+    if(isZero(T)) return;
+    if(!S) S = T;
+    else   S += T;
+    }
+
+//Apply the entry e of a SparseMPO to T,
+//where s is the unprimed site index of e's site
+template<class Tensor, class IndexT>
+Tensor
+applyElem(SparseMPOElem<Tensor> const& e,
+          Tensor const& T,
+          IndexT const& s)
+    {
+    if(e.isId)
+        {
+        auto res = prime(T,s);
+        scaleBy(res,e.coef);
+        return res;
+        }
+    return T*e.op;
+    }
+
+} //namespace detail
+
+} //namespace itensor
+
+#endif
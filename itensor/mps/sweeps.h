@@ -107,6 +107,20 @@ class Sweeps
     SweepSetter<int> 
     niter();
 
+    //Number of sites optimized at once (1 or 2).
+    //For one-site sweeps the noise value sets the
+    //strength of the single-site subspace expansion.
+    int 
+    numCenter(int sw) const { return numcenter_.at(sw); }
+    void 
+    setnumCenter(int sw, int val) { numcenter_.at(sw) = val; }
+    void 
+    setnumCenter(int val) { numcenter_.assign(nsweep_+1,val); }
+
+    //Use as sweeps.numCenter() = 2,2,1; (all remaining set to 1)
+    SweepSetter<int> 
+    numCenter();
+
     void
     read(std::istream& s);
 
@@ -123,7 +137,8 @@ class Sweeps
 
     std::vector<int> maxm_,
                      minm_,
-                     niter_;
+                     niter_,
+                     numcenter_;
     std::vector<Real> cutoff_,
                       noise_;
     int nsweep_;
@@ -337,6 +352,9 @@ noise() { return SweepSetter<Real>(noise_); }
 SweepSetter<int> inline Sweeps::
 niter() { return SweepSetter<int>(niter_); }
 
+SweepSetter<int> inline Sweeps::
+numCenter() { return SweepSetter<int>(numcenter_); }
+
 void inline Sweeps::
 nsweep(int val)
     { 
@@ -354,12 +372,14 @@ init(Args const& args)
     auto cutoff = args.getReal("Cutoff");
     auto noise = args.getReal("Noise",0.);
     auto niter = args.getInt("Niter",2);
+    auto numcenter = args.getInt("NumCenter",2);
 
     minm_ = std::vector<int>(nsweep_+1,min_m);
     maxm_ = std::vector<int>(nsweep_+1,max_m);
     cutoff_ = std::vector<Real>(nsweep_+1,cutoff);
     niter_ = std::vector<int>(nsweep_+1,niter);
     noise_ = std::vector<Real>(nsweep_+1,noise);
+    numcenter_ = std::vector<int>(nsweep_+1,numcenter);
 
     ////Set number of Davidson iterations
     //const int Max_niter = 9;
@@ -382,6 +402,7 @@ tableInit(InputGroup& table)
     cutoff_ = std::vector<Real>(nsweep_+1,0);
     niter_ = std::vector<int>(nsweep_+1,0);
     noise_ = std::vector<Real>(nsweep_+1,0);
+    numcenter_ = std::vector<int>(nsweep_+1,2);
 
     //printfln("Got nsweep_=%d",nsweep_);
     table.SkipLine(); //SkipLine so we can have a table key
@@ -410,26 +431,58 @@ tableInit(InputGroup& table)
 
     } //Sweeps::tableInit
 
+namespace detail {
+//Written first by Sweeps::write, followed by a format
+//version. Sweeps written before start with the size
+//of maxm_ instead, which is never this large.
+size_t const sweepsMarker = ~size_t(0);
+}
+
 void inline Sweeps::
 write(std::ostream& s) const
     {
+    itensor::write(s,detail::sweepsMarker);
+    itensor::write(s,int(1));
     itensor::write(s,maxm_);
     itensor::write(s,minm_);
     itensor::write(s,cutoff_);
     itensor::write(s,niter_);
     itensor::write(s,noise_);
     itensor::write(s,nsweep_);
+    itensor::write(s,numcenter_);
     }
 
 void inline Sweeps::
 read(std::istream& s)
     {
-    itensor::read(s,maxm_);
+    auto size = size_t(0);
+    itensor::read(s,size);
+    auto version = 0;
+    if(size == detail::sweepsMarker)
+        {
+        itensor::read(s,version);
+        if(version != 1) Error(format("Unknown Sweeps format version %d",version));
+        itensor::read(s,maxm_);
+        }
+    else
+        {
+        maxm_.resize(size);
+        s.read((char*)maxm_.data(),sizeof(int)*size);
+        }
     itensor::read(s,minm_);
     itensor::read(s,cutoff_);
     itensor::read(s,niter_);
     itensor::read(s,noise_);
     itensor::read(s,nsweep_);
+    if(version >= 1)
+        {
+        itensor::read(s,numcenter_);
+        }
+    else
+        {
+        //Sweeps written without a version were all two-site
+        numcenter_.assign(nsweep_+1,2);
+        }
     }
 
 inline std::ostream&
@@ -438,8 +491,8 @@ operator<<(std::ostream& s, const Sweeps& swps)
     s << "Sweeps:\n";
     for(int sw = 1; sw <= swps.nsweep(); ++sw)
         {
-        s << format("%d  Maxm=%d, Minm=%d, Cutoff=%.1E, Niter=%d, Noise=%.1E\n",
-              sw,swps.maxm(sw),swps.minm(sw),swps.cutoff(sw),swps.niter(sw),swps.noise(sw));
+        s << format("%d  Maxm=%d, Minm=%d, Cutoff=%.1E, Niter=%d, Noise=%.1E, NumCenter=%d\n",
+              sw,swps.maxm(sw),swps.minm(sw),swps.cutoff(sw),swps.niter(sw),swps.noise(sw),swps.numCenter(sw));
         }
     return s;
     }
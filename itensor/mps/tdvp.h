@@ -0,0 +1,258 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_TDVP_H
+#define __ITENSOR_TDVP_H
+
+#include "itensor/eigensolver.h"
+#include "itensor/mps/localmpo.h"
+#include "itensor/mps/sweeps.h"
+#include "itensor/mps/DMRGObserver.h"
+#include "itensor/util/cputime.h"
+
+namespace itensor {
+
+//
+// Time-dependent variational principle (TDVP) evolution
+// of the MPS psi under the Hamiltonian MPO H.
+//
+// Each sweep applies exp(t*H) to psi: use t = Cplx(0,-dt)
+// for real-time evolution by a time step dt, or t = -dt
+// for imaginary-time evolution. A sweep consists of a left
+// to right and a right to left half sweep, each evolving
+// the center site(s) forward by t/2 and the bond (one-site)
+// or site (two-site) between neighboring centers backward,
+// which makes each sweep a symmetric second-order step.
+// The local exponentials are computed with applyExp, so
+// H can be any MPO, including long-range AutoMPO terms.
+//
+// sweeps.numCenter(sw) selects one-site TDVP (bond dimension
+// of psi fixed) or two-site TDVP (bond dimension adapted
+// according to sweeps.maxm(sw), sweeps.minm(sw) and
+// sweeps.cutoff(sw)) for each sweep.
+//
+// Returns the energy <psi|H|psi> after the last sweep.
+//
+// Arguments recognized:
+// o "Normalize" (default: true) - normalize psi after each local step
+// o "MaxIter" (default: 30), "ErrGoal" (default: 1E-12) - passed to
+//   applyExp for the local exponentials
+// o "Quiet" (default: false) - suppress output
+// o Arguments of LocalMPO, such as "NThread"
+//
+template <class Tensor>
+Real
+tdvp(MPSt<Tensor>& psi,
+     MPOt<Tensor> const& H,
+     Cplx t,
+     Sweeps const& sweeps,
+     Args const& args = Args::global());
+
+//
+// TDVP with a user-supplied observer
+// (measure is called after each local step)
+//
+template <class Tensor>
+Real
+tdvp(MPSt<Tensor>& psi,
+     MPOt<Tensor> const& H,
+     Cplx t,
+     Sweeps const& sweeps,
+     DMRGObserver<Tensor>& obs,
+     Args args = Args::global());
+
+
+
+namespace detail {
+
+//
+// Hamiltonian projected onto the bond between two
+// sites, for the backward steps of one-site TDVP:
+// L includes sites 1,...,b and R sites b+1,...,N
+//
+template <class Tensor>
+class LocalBondOp
+    {
+    Tensor const* L_;
+    Tensor const* R_;
+    public:
+
+    LocalBondOp(Tensor const& L, Tensor const& R) : L_(&L), R_(&R) { }
+
+    void
+    product(Tensor const& phi, Tensor & phip) const
+        {
+        phip = *L_ ? (*L_)*phi : phi;
+        if(*R_) phip *= *R_;
+        phip.mapprime(1,0);
+        }
+    };
+
+//Evolve phi by exp(dt*A) in place, normalizing
+//the result if args has "DoNormalize" true
+template <class BigMatrixT, class Tensor>
+void
+tdvpEvolve(BigMatrixT const& A,
+           Tensor & phi,
+           Cplx dt,
+           Args const& args)
+    {
+    applyExp(A,phi,dt,args);
+    if(args.getBool("DoNormalize",true)) phi /= norm(phi);
+    }
+
+template <class Tensor>
+Real
+localEnergy(LocalMPO<Tensor> const& PH, Tensor const& phi)
+    {
+    Tensor Hphi;
+    PH.product(phi,Hphi);
+    return (dag(phi)*Hphi).cplx().real()/sqr(norm(phi));
+    }
+
+} //namespace detail
+
+template <class Tensor>
+Real
+tdvp(MPSt<Tensor>& psi,
+     MPOt<Tensor> const& H,
+     Cplx t,
+     Sweeps const& sweeps,
+     Args const& args)
+    {
+    DMRGObserver<Tensor> obs(psi,args);
+    return tdvp(psi,H,t,sweeps,obs,args);
+    }
+
+template <class Tensor>
+Real
+tdvp(MPSt<Tensor>& psi,
+     MPOt<Tensor> const& H,
+     Cplx t,
+     Sweeps const& sweeps,
+     DMRGObserver<Tensor>& obs,
+     Args args)
+    {
+    using IndexT = typename Tensor::index_type;
+    auto quiet = args.getBool("Quiet",false);
+
+    auto N = psi.N();
+    if(H.N() != N) Error("tdvp: mismatched N of psi and H");
+    if(N < 2) Error("tdvp: psi must have at least 2 sites");
+    Real energy = NAN;
+
+    psi.position(1);
+    auto PH = LocalMPO<Tensor>(H,args);
+
+    args.add("DoNormalize",args.getBool("Normalize",true));
+
+    for(int sw = 1; sw <= sweeps.nsweep(); ++sw)
+        {
+        cpu_time sw_time;
+        auto nc = sweeps.numCenter(sw);
+        if(nc != 1 && nc != 2) Error("tdvp: numCenter must be 1 or 2");
+        args.add("Sweep",sw);
+        args.add("NSweep",sweeps.nsweep());
+        args.add("Cutoff",sweeps.cutoff(sw));
+        args.add("Minm",sweeps.minm(sw));
+        args.add("Maxm",sweeps.maxm(sw));
+
+        for(int ha = 1; ha <= 2; ++ha)
+            {
+            auto nstep = (nc == 2) ? N-1 : N;
+            for(auto step : range1(nstep))
+                {
+                //Center: bond b = (b,b+1) for two-site,
+                //site b for one-site TDVP
+                auto b = (ha == 1) ? step : nstep+1-step;
+                auto last = (step == nstep);
+                auto spec = Spectrum();
+
+                if(nc == 2)
+                    {
+                    PH.numCenter(2);
+                    PH.position(b,psi);
+                    auto phi = psi.A(b)*psi.A(b+1);
+                    detail::tdvpEvolve(PH,phi,t/2.,args);
+                    if(last && ha == 2) energy = detail::localEnergy(PH,phi);
+                    spec = psi.svdBond(b,phi,(ha==1 ? Fromleft : Fromright),args);
+                    if(!last)
+                        {
+                        //Evolve the new center site backward
+                        auto j = (ha == 1) ? b+1 : b;
+                        PH.numCenter(1);
+                        PH.position(j,psi);
+                        auto A = psi.A(j);
+                        detail::tdvpEvolve(PH,A,-t/2.,args);
+                        psi.setA(j,A);
+                        }
+                    }
+                else
+                    {
+                    PH.numCenter(1);
+                    PH.position(b,psi);
+                    auto A = psi.A(b);
+                    detail::tdvpEvolve(PH,A,t/2.,args);
+                    if(last)
+                        {
+                        if(ha == 2) energy = detail::localEnergy(PH,A);
+                        psi.setA(b,A);
+                        }
+                    else
+                        {
+                        //Split off the bond tensor C toward the
+                        //next center site and evolve it backward
+                        auto n = (ha == 1) ? b+1 : b-1;
+                        auto l = commonIndex(psi.A(b),psi.A(n),Link);
+                        auto uinds = std::vector<IndexT>{};
+                        for(auto& I : A.inds()) if(I != l) uinds.push_back(I);
+                        auto U = Tensor(IndexSetT<IndexT>(std::move(uinds)));
+                        Tensor S,V;
+                        spec = svd(A,U,S,V,{"Truncate",false});
+                        psi.setA(b,U);
+                        auto C = S*V;
+                        //Edge tensor including the new site b
+                        auto E = (ha == 1) ? PH.L() : PH.R();
+                        E = E ? E*U : U;
+                        E *= H.A(b);
+                        E *= dag(prime(U));
+                        if(ha == 1) detail::tdvpEvolve(detail::LocalBondOp<Tensor>(E,PH.R()),C,-t/2.,args);
+                        else        detail::tdvpEvolve(detail::LocalBondOp<Tensor>(PH.L(),E),C,-t/2.,args);
+                        psi.setA(n,C*psi.A(n));
+                        }
+                    }
+
+                if(!quiet && nc == 2)
+                    {
+                    printfln("    Bond %d: trunc. err=%.1E, states kept: %s",
+                             b,spec.truncerr(),showm(linkInd(psi,b)));
+                    }
+
+                obs.lastSpectrum(spec);
+                args.add("AtBond",(nc == 2) ? b : std::min(b,N-1));
+                args.add("HalfSweep",ha);
+                args.add("Energy",energy);
+                args.add("Truncerr",spec.truncerr());
+                obs.measure(args);
+                }
+            }
+        psi.leftLim(0);
+        psi.rightLim(2);
+
+        if(!quiet)
+            {
+            auto sm = sw_time.sincemark();
+            printfln("    Sweep %d/%d CPU time = %s (Wall time = %s)",
+                      sw,sweeps.nsweep(),showtime(sm.time),showtime(sm.wall));
+            }
+
+        if(obs.checkDone(args)) break;
+        }
+
+    return energy;
+    }
+
+} //namespace itensor
+
+#endif
@@ -5,9 +5,11 @@
 #ifndef __ITENSOR_TEVOL_H
 #define __ITENSOR_TEVOL_H
 
+#include <array>
 #include "itensor/mps/mpo.h"
 #include "itensor/mps/bondgate.h"
 #include "itensor/mps/TEvolObserver.h"
+#include "itensor/util/threadpool.h"
 
 namespace itensor {
 
@@ -18,6 +20,22 @@ namespace itensor {
 //
 // Arguments recognized:
 //    "Verbose": if true, print useful information to stdout
+//    "Normalize" (default: true): normalize psi after each time step
+//    "Method":
+//       - (Default) "Serial": apply the gates one after another,
+//         moving the orthogonality center of psi to each gate
+//       - "Layered": keep psi in Vidal form (right-orthogonal
+//         site tensors plus the singular values of every bond)
+//         and apply each layer of consecutive gates acting on
+//         distinct nearest-neighbor bonds (such as the even or
+//         odd bonds of a Trotter step) at once, in parallel
+//    "NThread" (default: 1): number of threads applying the
+//       gates of a layer, for Method "Layered"
+//    "Regauge" (default: true): for Method "Layered", restore
+//       the Vidal form exactly with a sweep of SVDs after each
+//       time step; if false, this is done only after the last
+//       step, which suffices for unitary (real-time) gates
+//       since they preserve the form up to truncation
 //
 template <class Iterable, class Tensor>
 Real
@@ -41,6 +59,173 @@ gateTEvol(const Iterable& gatelist,
 // Implementations
 //
 
+namespace detail {
+
+//Bring psi into Vidal form: psi.A(2),...,psi.A(N) right-orthogonal,
+//psi.A(1) the orthogonality center, and lambda[b] the normalized
+//singular values of bond b (a diagonal tensor sharing an index
+//with psi.A(b+1)). Truncates according to args.
+template <class Tensor>
+void
+vidalForm(MPSt<Tensor>& psi,
+          std::vector<Tensor>& lambda,
+          Args const& args)
+    {
+    auto N = psi.N();
+    lambda.resize(N);
+    psi.position(N);
+    for(int j = N; j > 1; --j)
+        {
+        auto U = Tensor(commonIndex(psi.A(j-1),psi.A(j),Link));
+        Tensor S,V;
+        svd(psi.A(j),U,S,V,args);
+        psi.setA(j,V);
+        psi.setA(j-1,psi.A(j-1)*U*S);
+        lambda.at(j-1) = S/norm(S);
+        }
+    psi.leftLim(0);
+    psi.rightLim(2);
+    }
+
+//Apply the gate G on sites (j,j+1) to psi in Vidal form,
+//returning the new tensors for sites j and j+1 and updating
+//lambda[j]. Reads only psi.A(j), psi.A(j+1) and lambda[j-1],
+//so gates on distinct bonds can be applied concurrently.
+template <class Tensor>
+Spectrum
+vidalGate(MPSt<Tensor> const& psi,
+          std::vector<Tensor>& lambda,
+          Tensor const& G,
+          int j,
+          Tensor& Aj,
+          Tensor& Aj1,
+          Args const& args)
+    {
+    using IndexT = typename Tensor::index_type;
+    auto theta = psi.A(j)*psi.A(j+1)*G;
+    theta.mapprime(1,0,Site);
+    //Weight theta by the singular values to its left so the
+    //SVD truncates according to the full wavefunction
+    auto uinds = std::vector<IndexT>{psi.sites()(j)};
+    auto phi = theta;
+    if(j > 1)
+        {
+        auto& L = lambda.at(j-1);
+        for(auto& I : L.inds()) if(!hasindex(psi.A(j),I)) uinds.push_back(I);
+        phi *= L;
+        }
+    auto U = Tensor(IndexSetT<IndexT>(std::move(uinds)));
+    Tensor S;
+    auto spec = svd(phi,U,S,Aj1,args);
+    lambda.at(j) = S/norm(S);
+    //Avoids dividing by the singular values of bond j-1
+    Aj = theta*dag(Aj1);
+    return spec;
+    }
+
+//Split gatelist into layers of consecutive gates
+//acting on distinct nearest-neighbor bonds
+template <class Iterable>
+std::vector<std::vector<typename Iterable::value_type const*>>
+gateLayers(Iterable const& gatelist)
+    {
+    using GateT = typename Iterable::value_type;
+    auto layers = std::vector<std::vector<GateT const*>>{};
+    auto used = std::vector<int>{};
+    for(auto& g : gatelist)
+        {
+        if(g.i2() != g.i1()+1) Error("gateTEvol: Method \"Layered\" requires gates on nearest-neighbor sites");
+        auto overlaps = false;
+        for(auto i : used) if(i == g.i1() || i == g.i2()) overlaps = true;
+        if(layers.empty() || overlaps)
+            {
+            layers.emplace_back();
+            used.clear();
+            }
+        layers.back().push_back(&g);
+        used.push_back(g.i1());
+        used.push_back(g.i2());
+        }
+    return layers;
+    }
+
+template <class Iterable, class Tensor>
+Real
+layeredTEvol(Iterable const& gatelist, 
+             int nt,
+             Real tstep, 
+             MPSt<Tensor>& psi, 
+             Observer& obs,
+             Args args)
+    {
+    auto verbose = args.getBool("Verbose",false);
+    auto normalize = args.getBool("Normalize",true);
+    auto regauge = args.getBool("Regauge",true);
+    auto nthread = args.getInt("NThread",1);
+    if(nthread < 1) Error("NThread must be set >= 1");
+    if(psi.doWrite()) Error("gateTEvol: Method \"Layered\" requires psi in memory (doWrite false)");
+
+    auto layers = gateLayers(gatelist);
+    auto N = psi.N();
+    auto lambda = std::vector<Tensor>{};
+    vidalForm(psi,lambda,args);
+    Real tot_norm = norm(psi);
+
+    Real tsofar = 0;
+    for(int tt = 1; tt <= nt; ++tt)
+        {
+        for(auto& layer : layers)
+            {
+            auto ng = layer.size();
+            auto newA = std::vector<std::array<Tensor,2>>(ng);
+            auto truncerr = std::vector<Real>(ng,0.);
+            auto nthr = std::min(size_t(nthread),ng);
+            parallelFor(nthr,[&](size_t t)
+                {
+                for(auto n = t; n < ng; n += nthr)
+                    {
+                    auto& g = *layer[n];
+                    auto spec = vidalGate(psi,lambda,g.gate(),g.i1(),newA[n][0],newA[n][1],args);
+                    truncerr[n] = spec.truncerr();
+                    }
+                });
+            for(auto n : range(ng))
+                {
+                auto j = layer[n]->i1();
+                psi.setA(j,std::move(newA[n][0]));
+                psi.setA(j+1,std::move(newA[n][1]));
+                if(verbose) printfln("    Bond %d: trunc. err=%.1E, states kept: %s",
+                                     j,truncerr[n],showm(linkInd(psi,j)));
+                }
+            }
+
+        if(regauge || tt == nt)
+            {
+            //Setting rightLim to N+1 makes position
+            //re-orthogonalize every site of psi
+            psi.leftLim(0);
+            psi.rightLim(N+1);
+            vidalForm(psi,lambda,args);
+            if(normalize) tot_norm *= psi.normalize();
+            }
+
+        tsofar += tstep;
+
+        args.add("TimeStepNum",tt);
+        args.add("Time",tsofar);
+        args.add("TotalTime",nt*tstep);
+        obs.measure(args);
+        }
+    if(verbose) 
+        {
+        printfln("\nTotal time evolved = %.5f\n",tsofar);
+        }
+
+    return tot_norm;
+    }
+
+} //namespace detail
+
 template <class Iterable, class Tensor>
 Real
 gateTEvol(Iterable const& gatelist, 
@@ -52,6 +237,11 @@ gateTEvol(Iterable const& gatelist,
     {
     const bool verbose = args.getBool("Verbose",false);
     const bool normalize = args.getBool("Normalize",true);
+    auto method = args.getString("Method","Serial");
+    if(method != "Serial" && method != "Layered")
+        {
+        Error(format("gateTEvol: unknown Method \"%s\"",method));
+        }
 
     const int nt = int(ttotal/tstep+(1e-9*(ttotal/tstep)));
     if(fabs(nt*tstep-ttotal) > 1E-9)
@@ -64,6 +254,8 @@ gateTEvol(Iterable const& gatelist,
         printfln("Taking %d steps of timestep %.5f, total time %.5f",nt,tstep,ttotal);
         }
 
+    if(method == "Layered") return detail::layeredTEvol(gatelist,nt,tstep,psi,obs,args);
+
     psi.position(gatelist.front().i1());
     Real tot_norm = norm(psi);
 
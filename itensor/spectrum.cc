@@ -4,6 +4,7 @@
 //
 #include <algorithm>
 #include <utility>
+#include <cmath>
 #include "itensor/spectrum.h"
 
 using std::move;
@@ -98,6 +99,38 @@ computeTruncerr(Args const& args)
         }
     }
 
+Real
+entropy(Spectrum const& spec, Real alpha)
+    {
+    auto& eigs = spec.eigsKept();
+    Real S = 0;
+    if(alpha == 1.)
+        {
+        for(auto& p : eigs) if(p > 0) S -= p*std::log(p);
+        return S;
+        }
+    for(auto& p : eigs) if(p > 0) S += std::pow(p,alpha);
+    return std::log(S)/(1.-alpha);
+    }
+
+std::vector<std::pair<QN,Real>>
+qnWeights(Spectrum const& spec)
+    {
+    if(!spec.hasQNs()) Error("qnWeights: Spectrum has no QNs (use \"ComputeQNs\" option of svd)");
+    auto res = std::vector<std::pair<QN,Real>>{};
+    for(auto n : range1(spec.numEigsKept()))
+        {
+        auto q = spec.qn(n);
+        auto it = std::find_if(res.begin(),res.end(),
+                               [&q](std::pair<QN,Real> const& w) { return w.first == q; });
+        if(it == res.end()) res.emplace_back(q,spec.eig(n));
+        else                it->second += spec.eig(n);
+        }
+    std::sort(res.begin(),res.end(),
+              [](std::pair<QN,Real> const& a, std::pair<QN,Real> const& b) { return a.first < b.first; });
+    return res;
+    }
+
 std::ostream& 
 operator<<(std::ostream & s, Spectrum const& spec)
     {
@@ -76,6 +76,19 @@ class Spectrum
 
     }; //class Spectrum
 
+//Entanglement entropy of the eigenvalues p_n of spec
+//(taken to be normalized probabilities): the von Neumann
+//entropy -sum_n p_n log(p_n) if alpha == 1, otherwise
+//the Renyi entropy log(sum_n p_n^alpha)/(1-alpha)
+Real
+entropy(Spectrum const& spec, Real alpha = 1.);
+
+//Total weight of the eigenvalues of spec in each
+//QN sector, in increasing order of QN
+//(requires spec.hasQNs())
+std::vector<std::pair<QN,Real>>
+qnWeights(Spectrum const& spec);
+
 std::ostream& 
 operator<<(std::ostream & s,Spectrum const& spec);
 
@@ -34,6 +34,9 @@ namespace itensor {
 //   func(T1 t1, T2 t2, ..., const Args& args = Args::global());
 //   which will incur essentially no overhead.
 //   If you intend to add or modify the args set, take it by value.
+// o Args::global() is shared by all threads unless
+//   a thread makes a ScopedGlobalArgs (see below),
+//   so set global values before starting threads.
 //
 
 class Args
@@ -148,10 +151,13 @@ class Args
     bool
     isGlobal() const { return (this == &global()); }
 
-    // Access the global Args object
+    // Access the global Args object: the Args of the
+    // innermost ScopedGlobalArgs of the calling thread
+    // if there is one, otherwise the process-wide Args
     static Args&
     global()
         {
+        if(scopedGlobal()) return *scopedGlobal();
         static Args gos_;
         return gos_;
         }
@@ -166,6 +172,15 @@ class Args
 
     private:
 
+    static Args*&
+    scopedGlobal()
+        {
+        static thread_local Args* sg_ = nullptr;
+        return sg_;
+        }
+
+    friend class ScopedGlobalArgs;
+
     void
     processString(std::string ostring);
 
@@ -298,6 +313,66 @@ Args(Args const& other,
     initialize(other,rest...);
     }
 
+//
+// ScopedGlobalArgs gives the thread making it its own
+// global Args, initially a copy of the previous one, until
+// it is destroyed. Use it to run a simulation which sets
+// global values (for example through Global::args)
+// concurrently with others:
+//
+// std::thread([&]{ ScopedGlobalArgs ga; ... });
+//
+// Threads started by detail::parallelFor (used by
+// functions accepting "NThread") share the global Args
+// of the thread starting them, read-only.
+//
+class ScopedGlobalArgs
+    {
+    Args args_;
+    Args* cur_ = nullptr;
+    Args* prev_ = nullptr;
+    public:
+
+    ScopedGlobalArgs()
+      : prev_(Args::scopedGlobal())
+        {
+        //Copying Args::global() gives an empty Args,
+        //so copy its values
+        args_.vals_ = Args::global().vals_;
+        cur_ = &args_;
+        Args::scopedGlobal() = cur_;
+        }
+
+    //Use the global Args ga of another thread (from
+    //threadGlobal(), null for the process-wide Args)
+    explicit
+    ScopedGlobalArgs(Args* ga)
+      : cur_(ga),
+        prev_(Args::scopedGlobal())
+        {
+        Args::scopedGlobal() = cur_;
+        }
+
+    ScopedGlobalArgs(ScopedGlobalArgs const&) = delete;
+    ScopedGlobalArgs&
+    operator=(ScopedGlobalArgs const&) = delete;
+
+    ~ScopedGlobalArgs()
+        {
+        Args::scopedGlobal() = prev_;
+        }
+
+    //The global Args of this scope (empty for
+    //the process-wide Args)
+    Args&
+    args() { return cur_ ? *cur_ : args_; }
+
+    //The Args of the innermost ScopedGlobalArgs of the
+    //calling thread, or null if it has none
+    static Args*
+    threadGlobal() { return Args::scopedGlobal(); }
+    };
+
 Args
 operator+(Args args, Args const& other);
 
@@ -1,13 +1,20 @@
 #ifndef __ITENSOR_PARALLEL_H
 #define __ITENSOR_PARALLEL_H
 #include "mpi.h"
+#include <algorithm>
+#include <cstdint>
 #include <sstream>
+#include <streambuf>
 #include <vector>
 #include <type_traits>
 #include "itensor/util/readwrite.h"
 #include "itensor/util/args.h"
+#include "itensor/util/range.h"
+#include "itensor/iqtensor.h"
 
-#define DEFAULT_BUFSIZE 500000
+//Largest number of bytes passed to a single MPI call;
+//longer messages are split into several calls
+#define DEFAULT_BUFSIZE 268435456
 
 namespace itensor {
 
@@ -39,11 +46,159 @@ template <typename T>
 T
 allSum(Environment const& env, T &obj);
 
+//
+// Reductions of ITensors or IQTensors having the same
+// indices (in any order) and, for IQTensors, the same
+// divergence on every node. Unlike sum and allSum, the
+// tensor data is reduced in place by MPI without
+// serializing the tensors. The tensors must have dense
+// storage; if the tensor on any node is complex, the
+// reduction is complex on all nodes. A null tensor counts
+// as zero (the result is null if it is null on all nodes).
+// The operation op can be MPI_SUM, MPI_PROD, or, for
+// real tensors, MPI_MAX or MPI_MIN.
+//
+
+//Replace T on every node by the reduction of T over all nodes
+template <typename IndexT>
+void
+allReduce(Environment const& env, ITensorT<IndexT> & T, MPI_Op op = MPI_SUM);
+
+//Replace T on node root by the reduction of T over all nodes
+//(T is left unchanged, up to its index order, on other nodes)
+template <typename IndexT>
+void
+reduce(Environment const& env, ITensorT<IndexT> & T, int root = 0, MPI_Op op = MPI_SUM);
+
+//Given v with one tensor per node on every node, returns
+//on node n the reduction of v[n] over all nodes
+template <typename IndexT>
+ITensorT<IndexT>
+reduceScatter(Environment const& env, std::vector<ITensorT<IndexT>> const& v, MPI_Op op = MPI_SUM);
+
+namespace detail {
+
+//Output stream buffer appending to a std::vector<char>.
+//Clearing the vector keeps its memory, so the same vector
+//can be reused for many messages without reallocating.
+class VectorOutBuf : public std::streambuf
+    {
+    std::vector<char>& v_;
+    public:
+
+    VectorOutBuf(std::vector<char>& v) : v_(v) { }
+
+    protected:
+
+    std::streamsize
+    xsputn(char const* s, std::streamsize n) override
+        {
+        v_.insert(v_.end(),s,s+n);
+        return n;
+        }
+
+    int_type
+    overflow(int_type c) override
+        {
+        if(c != traits_type::eof()) v_.push_back(traits_type::to_char_type(c));
+        return traits_type::not_eof(c);
+        }
+    };
+
+//Input stream buffer reading from an array in place
+class ArrayInBuf : public std::streambuf
+    {
+    public:
+
+    ArrayInBuf(char* p, size_t n) { setg(p,p,p+n); }
+    };
+
+//Write obj in binary form to buf, replacing its contents
+template <class T>
+void
+writeBuffer(std::vector<char>& buf, T const& obj)
+    {
+    buf.clear();
+    VectorOutBuf sb(buf);
+    std::ostream s(&sb);
+    itensor::write(s,obj);
+    }
+
+//Read obj from the contents of buf
+template <class T>
+void
+readBuffer(std::vector<char>& buf, T & obj)
+    {
+    ArrayInBuf sb(buf.data(),buf.size());
+    std::istream s(&sb);
+    itensor::read(s,obj);
+    }
+
+//Offsets and sizes of the chunks of at
+//most chunk bytes making up size bytes
+std::vector<std::pair<long,int>> inline
+messageChunks(long size, long chunk)
+    {
+    auto res = std::vector<std::pair<long,int>>{};
+    for(long off = 0; off < size; off += chunk)
+        {
+        res.emplace_back(off,int(std::min(chunk,size-off)));
+        }
+    return res;
+    }
+
+//Pointer to the (contiguous) data of dense tensor
+//storage, and a signature of its layout, which must
+//agree on all nodes for the data to be reduced in place
+struct RawData
+    {
+    void* data = nullptr;
+    long size = 0;
+    long cplx = 0;
+    long nblock = -1;
+    long offsets = 0;
+    };
+
+struct GetRawData { };
+
+template <typename T>
+RawData
+doTask(GetRawData, Dense<T> & d)
+    {
+    auto R = RawData{};
+    R.data = d.data();
+    R.size = d.size();
+    R.cplx = isCplx(d);
+    return R;
+    }
+
+template <typename T>
+RawData
+doTask(GetRawData, QDense<T> & d)
+    {
+    auto R = RawData{};
+    R.data = d.data();
+    R.size = d.size();
+    R.cplx = isCplx(d);
+    R.nblock = d.offsets.size();
+    //Hash of the block offsets, unsigned so that it can wrap
+    auto h = uint64_t(0);
+    for(auto& bo : d.offsets)
+        {
+        h = 1000003*h + 31*uint64_t(bo.block) + uint64_t(bo.offset);
+        }
+    R.offsets = long(h >> 1);
+    return R;
+    }
+
+} //namespace detail
+
 class Environment
     {
     int rank_,
         nnodes_;
-    mutable std::vector<char> buffer;
+    long chunk_;
+    mutable std::vector<char> buffer_;
     public:
 
     Environment(int argc, char* argv[],
@@ -78,6 +233,20 @@ class Environment
     void 
     broadcast(std::stringstream& data) const;
 
+    //Broadcast the bytes of data from node root,
+    //resizing data on the other nodes
+    void 
+    broadcast(std::vector<char>& data, int root = 0) const;
+
+    //Maximum bytes sent in a single MPI call
+    long
+    bufsize() const { return chunk_; }
+
+    //Buffer reused by broadcasts of objects,
+    //holding their serialized form
+    std::vector<char>&
+    buffer() const { return buffer_; }
+
     void 
     barrier() const { MPI_Barrier(MPI_COMM_WORLD); }
 
@@ -104,16 +273,35 @@ class Environment
 
     };
 
+//
+// Point-to-point messages with another node.
+//
+// Objects are serialized with itensor::write directly into
+// a send buffer owned by the MailBox (whose memory is reused
+// by later messages) and sent with non-blocking calls, so
+// send returns without waiting for the other node. The
+// buffer is kept until the message has been delivered:
+// call wait(), or send again or destroy the MailBox, which
+// wait as needed. Received messages are read in place from
+// a receive buffer, also reused.
+//
 class MailBox
     {
     Environment const* env_;
     MPI_Comm com;
     int other_node_;
-    char flag_;
+    //flag_ receives the flag of incoming messages and
+    //sflag_ is sent with outgoing ones, so that a pending
+    //receive never writes the buffer of a pending send
+    char flag_,
+         sflag_;
     MPI_Request req_;
     MPI_Status rstatus_;
-    std::string sdata;
-    std::vector<char> rbuffer;
+    long chunk_;
+    long ssize_;
+    std::vector<char> sbuffer_,
+                      rbuffer_;
+    std::vector<MPI_Request> sreqs_;
     int tag_;
     public:
 
@@ -158,18 +346,35 @@ class MailBox
     void 
     send(std::stringstream const& data);
 
+    //Wait until the last message sent has been delivered
+    void
+    wait();
+
     template <class T> 
     void 
     broadcast(T& obj) const { checkValid(); env_->broadcast(obj); }
 
     private:
 
+    //Make this class non-copyable
+    //(pending sends refer to its buffer)
+    void operator=(MailBox const&);
+    MailBox(MailBox const&);
+
     void
     checkValid() const
         {
         if(env_==nullptr) throw std::runtime_error("MailBox object is default initialized.");
         }
 
+    //Send the contents of sbuffer_
+    void
+    postSend();
+
+    //Receive a message into rbuffer_
+    void
+    receiveBuffer();
+
     void 
     listenForFlag()
         { 
@@ -220,50 +425,42 @@ parallelDebugWait(Environment const& env)
 inline Environment::
 Environment(int argc, char* argv[],
             Args const& args)
-    : buffer(args.getInt("Bufsize",DEFAULT_BUFSIZE))
+    : chunk_(args.getInt("Bufsize",DEFAULT_BUFSIZE))
     { 
+    if(chunk_ < 1) Error("Bufsize must be >= 1");
     MPI_Init(&argc,&argv); 
     MPI_Comm_rank(MPI_COMM_WORLD,&rank_); 
     MPI_Comm_size(MPI_COMM_WORLD,&nnodes_); 
     }
 
+void inline Environment::
+broadcast(std::vector<char>& data, int root) const
+    { 
+    if(nnodes_ == 1) return;
+    long size = data.size();
+    MPI_Bcast(&size,1,MPI_LONG,root,MPI_COMM_WORLD);
+    if(rank_ != root) data.resize(size);
+    auto chunks = detail::messageChunks(size,chunk_);
+    auto reqs = std::vector<MPI_Request>(chunks.size());
+    for(auto n : range(chunks.size()))
+        {
+        MPI_Ibcast(data.data()+chunks[n].first,chunks[n].second,MPI_CHAR,root,MPI_COMM_WORLD,&reqs[n]);
+        }
+    MPI_Waitall(reqs.size(),reqs.data(),MPI_STATUSES_IGNORE);
+    }
+
 void inline Environment::
 broadcast(std::stringstream& data) const
     { 
     if(nnodes_ == 1) return;
     const int root = 0;
-    const int shift = 2;
     if(rank_ == root)
         {
-        int size = data.str().length(); 
-        int quo = size/buffer.size(), 
-            rem = size%buffer.size();
-        MPI_Bcast(&quo,1,MPI_INT,root,MPI_COMM_WORLD);
-        MPI_Bcast(&rem,1,MPI_INT,root,MPI_COMM_WORLD);
-        //std::cout << "Doing broadcast (quo,rem) = (" << quo << "," << rem << ")" << std::endl;
-        for(int q = 0; q < quo; ++q)
-            { 
-            //printfln("Node %d q = %d/%d",rank_,q,(quo-1));
-            MPI_Bcast(const_cast<char*>(data.str().data())+q*buffer.size(),buffer.size(),MPI_CHAR,root,MPI_COMM_WORLD); 
-            }
-        MPI_Bcast(const_cast<char*>(data.str().data())+quo*buffer.size(),rem+shift,MPI_CHAR,root,MPI_COMM_WORLD);
-        }
-    else
-        {
-        int quo=0,rem=0;
-        MPI_Bcast(&quo,1,MPI_INT,root,MPI_COMM_WORLD);
-        MPI_Bcast(&rem,1,MPI_INT,root,MPI_COMM_WORLD);
-        //printfln("Node %d got quo,rem = %d,%d",rank_,quo,rem);
-        for(int q = 0; q < quo; ++q)
-            { 
-            //printfln("Node %d q = %d/%d",rank_,q,(quo-1));
-            MPI_Bcast(&buffer.front(),buffer.size(),MPI_CHAR,root,MPI_COMM_WORLD); 
-            data.write(&buffer.front(),buffer.size());
-            }
-        MPI_Bcast(&buffer.front(),rem+shift,MPI_CHAR,root,MPI_COMM_WORLD);
-        data.write(&buffer.front(),rem+shift);
+        auto str = data.str();
+        buffer_.assign(str.begin(),str.end());
         }
-    //printfln("%d reached end of broadcast(stringstream)",rank_);
+    broadcast(buffer_);
+    if(rank_ != root) data.write(buffer_.data(),buffer_.size());
     }
 
 template <class T>
@@ -272,10 +469,10 @@ broadcast(Environment const& env, T & obj)
     {
     if(env.nnodes() == 1) return;
     const int root = 0;
-    std::stringstream datastream;
-    if(env.rank() == root) itensor::write(datastream,obj);
-    env.broadcast(datastream);
-    if(env.rank() != root) itensor::read(datastream,obj);
+    auto& buf = env.buffer();
+    if(env.rank() == root) detail::writeBuffer(buf,obj);
+    env.broadcast(buf);
+    if(env.rank() != root) detail::readBuffer(buf,obj);
     }
 
 template <class T, class... Rest>
@@ -413,6 +610,187 @@ allSum(Environment const& env, T &obj)
     return result;
     }
 
+namespace detail {
+
+QN inline
+reduceDiv(ITensor const& T) { return QN(); }
+
+QN inline
+reduceDiv(IQTensor const& T) { return div(T); }
+
+void inline
+allocZero(ITensor& T, QN const&) { T.store() = newITData<DenseReal>(area(T.inds()),0); }
+
+void inline
+allocZero(IQTensor& T, QN const& div) { T.store() = newITData<QDenseReal>(T.inds(),div); }
+
+//Check that T has the indices of T on the first node where
+//it is not null and the same storage layout on all nodes,
+//converting T to complex if it is complex on any node. A null
+//T is replaced by a zero tensor. Returns a pointer to the data
+//of T and its size, or a size of -1 if T is null on all nodes.
+//All nodes call Error together if the check fails.
+template <typename IndexT>
+RawData
+prepareReduce(Environment const& env, ITensorT<IndexT> & T)
+    {
+    int root = T ? env.rank() : env.nnodes();
+    MPI_Allreduce(MPI_IN_PLACE,&root,1,MPI_INT,MPI_MIN,MPI_COMM_WORLD);
+    if(root == env.nnodes())
+        {
+        auto R = RawData{};
+        R.size = -1;
+        return R;
+        }
+
+    auto is = T.inds();
+    auto dv = T ? reduceDiv(T) : QN();
+    env.buffer().clear();
+    if(env.rank() == root) writeBuffer(env.buffer(),is);
+    env.broadcast(env.buffer(),root);
+    if(env.rank() != root) readBuffer(env.buffer(),is);
+    env.buffer().clear();
+    if(env.rank() == root) writeBuffer(env.buffer(),dv);
+    env.broadcast(env.buffer(),root);
+    if(env.rank() != root) readBuffer(env.buffer(),dv);
+    if(!T)
+        {
+        T = ITensorT<IndexT>(is);
+        allocZero(T,dv);
+        }
+
+    long bad = rank(T) != long(rank(is));
+    if(!bad)
+        {
+        for(auto& I : is) if(!hasindex(T,I)) bad = 1;
+        }
+    MPI_Allreduce(MPI_IN_PLACE,&bad,1,MPI_LONG,MPI_MAX,MPI_COMM_WORLD);
+    if(bad) Error("Tensors to reduce must have the same indices on all nodes");
+
+    auto inorder = true;
+    for(auto n : range1(rank(is))) if(T.inds()[n-1] != is[n-1]) inorder = false;
+    if(!inorder) T.order(is);
+    T.scaleTo(1.);
+
+    long cplx = isComplex(T);
+    MPI_Allreduce(MPI_IN_PLACE,&cplx,1,MPI_LONG,MPI_MAX,MPI_COMM_WORLD);
+    if(cplx && isReal(T)) doTask(Mult<Cplx>(1.),T.store());
+
+    auto R = RawData{};
+    try
+        {
+        R = doTask(GetRawData{},T.store());
+        }
+    catch(ITError const&)
+        {
+        R.size = -1;
+        }
+    long sig[4] = {R.size,R.cplx,R.nblock,R.offsets},
+         minsig[4];
+    MPI_Allreduce(sig,minsig,4,MPI_LONG,MPI_MIN,MPI_COMM_WORLD);
+    for(auto n : range(4)) if(sig[n] != minsig[n]) bad = 1;
+    MPI_Allreduce(MPI_IN_PLACE,&bad,1,MPI_LONG,MPI_MAX,MPI_COMM_WORLD);
+    if(minsig[0] < 0) Error("Tensors to reduce must have dense storage on all nodes");
+    if(bad) Error("Tensors to reduce must have the same storage layout on all nodes");
+    return R;
+    }
+
+//Call f(data,count,type) for chunks of at most chunk bytes of R
+template <typename F>
+void
+forRawChunks(RawData const& R, long chunk, F&& f)
+    {
+    auto type = R.cplx ? MPI_CXX_DOUBLE_COMPLEX : MPI_DOUBLE;
+    long elsize = R.cplx ? sizeof(Cplx) : sizeof(Real);
+    auto p = reinterpret_cast<char*>(R.data);
+    for(auto& c : messageChunks(R.size,std::max(1L,chunk/elsize)))
+        {
+        f(p+c.first*elsize,c.second,type);
+        }
+    }
+
+//Reduce the data of T over all nodes, for a T which has the
+//same indices in the same order and the same storage layout on
+//every node (as checked by allReduce for an earlier tensor made
+//the same way), converting it to complex if cplx. Unlike
+//allReduce it makes no communication besides the reduction.
+template <typename IndexT>
+void
+allReduceData(Environment const& env, ITensorT<IndexT> & T, bool cplx, MPI_Op op = MPI_SUM)
+    {
+    if(env.nnodes() == 1) return;
+    T.scaleTo(1.);
+    if(cplx && isReal(T)) doTask(Mult<Cplx>(1.),T.store());
+    auto R = doTask(GetRawData{},T.store());
+    forRawChunks(R,env.bufsize(),[op](void* p, int n, MPI_Datatype type)
+        {
+        MPI_Allreduce(MPI_IN_PLACE,p,n,type,op,MPI_COMM_WORLD);
+        });
+    }
+
+//Reduce the data of T over all nodes onto node root, for
+//a T prepared as for allReduceData
+template <typename IndexT>
+void
+reduceData(Environment const& env, ITensorT<IndexT> & T, int root, bool cplx, MPI_Op op = MPI_SUM)
+    {
+    if(env.nnodes() == 1) return;
+    T.scaleTo(1.);
+    if(cplx && isReal(T)) doTask(Mult<Cplx>(1.),T.store());
+    auto R = doTask(GetRawData{},T.store());
+    auto isroot = (env.rank() == root);
+    forRawChunks(R,env.bufsize(),[op,root,isroot](void* p, int n, MPI_Datatype type)
+        {
+        if(isroot) MPI_Reduce(MPI_IN_PLACE,p,n,type,op,root,MPI_COMM_WORLD);
+        else       MPI_Reduce(p,nullptr,n,type,op,root,MPI_COMM_WORLD);
+        });
+    }
+
+} //namespace detail
+
+template <typename IndexT>
+void
+allReduce(Environment const& env, ITensorT<IndexT> & T, MPI_Op op)
+    {
+    if(env.nnodes() == 1) return;
+    auto R = detail::prepareReduce(env,T);
+    if(R.size < 0) return;
+    detail::forRawChunks(R,env.bufsize(),[op](void* p, int n, MPI_Datatype type)
+        {
+        MPI_Allreduce(MPI_IN_PLACE,p,n,type,op,MPI_COMM_WORLD);
+        });
+    }
+
+template <typename IndexT>
+void
+reduce(Environment const& env, ITensorT<IndexT> & T, int root, MPI_Op op)
+    {
+    if(env.nnodes() == 1) return;
+    auto R = detail::prepareReduce(env,T);
+    if(R.size < 0) return;
+    auto isroot = (env.rank() == root);
+    detail::forRawChunks(R,env.bufsize(),[op,root,isroot](void* p, int n, MPI_Datatype type)
+        {
+        if(isroot) MPI_Reduce(MPI_IN_PLACE,p,n,type,op,root,MPI_COMM_WORLD);
+        else       MPI_Reduce(p,nullptr,n,type,op,root,MPI_COMM_WORLD);
+        });
+    }
+
+template <typename IndexT>
+ITensorT<IndexT>
+reduceScatter(Environment const& env, std::vector<ITensorT<IndexT>> const& v, MPI_Op op)
+    {
+    if(long(v.size()) != env.nnodes()) Error("reduceScatter: v must have one tensor per node");
+    auto res = ITensorT<IndexT>{};
+    for(auto n : range(env.nnodes()))
+        {
+        auto T = v[n];
+        reduce(env,T,n,op);
+        if(n == env.rank()) res = std::move(T);
+        }
+    return res;
+    }
+
 //
 // MailBox
 //
@@ -434,7 +812,9 @@ MailBox(Environment const& env,
     com(MPI_COMM_WORLD), 
     other_node_(other_node), 
     flag_('f'),
-    rbuffer(args.getInt("Bufsize",DEFAULT_BUFSIZE)),
+    sflag_('f'),
+    chunk_(args.getInt("Bufsize",DEFAULT_BUFSIZE)),
+    ssize_(0),
     tag_(new_tag(env,other_node))
     { 
     if(other_node_ >= env_->nnodes())
@@ -442,87 +822,106 @@ MailBox(Environment const& env,
         std::cout << "\n\nNode " << env_->rank() << ": other_node = " << other_node_ << " out of range." << std::endl;
         throw std::runtime_error("other_node out of range"); 
         }
+    if(chunk_ < 1) Error("Bufsize must be >= 1");
     //Initiate flag receive request
     listenForFlag();
     }
 inline MailBox::
 ~MailBox() 
     { 
-    if(env_) MPI_Cancel(&req_); 
+    if(!env_) return;
+    wait();
+    MPI_Cancel(&req_); 
+    MPI_Request_free(&req_);
     }
 
 void inline MailBox::
-receive(std::stringstream& data)
+wait()
+    {
+    if(sreqs_.empty()) return;
+    MPI_Waitall(sreqs_.size(),sreqs_.data(),MPI_STATUSES_IGNORE);
+    sreqs_.clear();
+    }
+
+void inline MailBox::
+receiveBuffer()
     {
     checkValid();
     MPI_Wait(&req_,&rstatus_); 
 
-    int msize = 0;
-    MPI_Recv(&msize,1,MPI_INT,other_node_,sizeTag(),com,&rstatus_);
+    long msize = 0;
+    MPI_Recv(&msize,1,MPI_LONG,other_node_,sizeTag(),com,&rstatus_);
 
-    int quo = msize/rbuffer.size(), 
-        rem = msize%rbuffer.size();
-    for(int q = 0; q < quo; ++q)
+    rbuffer_.resize(msize);
+    auto chunks = detail::messageChunks(msize,chunk_);
+    auto reqs = std::vector<MPI_Request>(chunks.size());
+    for(auto n : range(chunks.size()))
         {
-        MPI_Recv(&rbuffer.front(),rbuffer.size(),MPI_CHAR,other_node_,tag(),com,&rstatus_);
-        data.write(&rbuffer.front(),rbuffer.size());
+        MPI_Irecv(rbuffer_.data()+chunks[n].first,chunks[n].second,MPI_CHAR,other_node_,tag(),com,&reqs[n]);
         }
-    MPI_Recv(&rbuffer.front(),rem,MPI_CHAR,other_node_,tag(),com,&rstatus_);
-    data.write(&rbuffer.front(),rem);
+    MPI_Waitall(reqs.size(),reqs.data(),MPI_STATUSES_IGNORE);
 
     //Reset flag_
     listenForFlag();
     }
 
+void inline MailBox::
+receive(std::stringstream& data)
+    {
+    receiveBuffer();
+    data.write(rbuffer_.data(),rbuffer_.size());
+    }
+
 template <class T>
 void MailBox::
 receive(T& obj)
     { 
-    std::stringstream data; 
-    receive(data); 
-    itensor::read(data,obj);
+    receiveBuffer();
+    detail::readBuffer(rbuffer_,obj);
     }
 
 template <class T, typename... Args>
 T MailBox::
 receive(Args&&... args)
     { 
-    std::stringstream data; 
-    receive(data); 
+    receiveBuffer();
     T obj(std::forward<Args>(args)...);
-    itensor::read(data,obj);
+    detail::readBuffer(rbuffer_,obj);
     return obj;
     }
 
-
 void inline MailBox::
-send(std::stringstream const& data)
+postSend()
     {
-    checkValid();
-    sdata.assign(data.str());
-    int msize = sdata.length();
-    int quo = msize/rbuffer.size(), 
-        rem = msize%rbuffer.size();
-
-    MPI_Send(&flag_,1,MPI_CHAR,other_node_,flagTag(),com);
-    MPI_Send(&msize,1,MPI_INT,other_node_,sizeTag(),com);
-
-    auto datap = const_cast<char*>(sdata.data());
-    for(int q = 0; q < quo; ++q)
+    ssize_ = sbuffer_.size();
+    auto chunks = detail::messageChunks(ssize_,chunk_);
+    sreqs_.resize(2+chunks.size());
+    MPI_Isend(&sflag_,1,MPI_CHAR,other_node_,flagTag(),com,&sreqs_[0]);
+    MPI_Isend(&ssize_,1,MPI_LONG,other_node_,sizeTag(),com,&sreqs_[1]);
+    for(auto n : range(chunks.size()))
         {
-        MPI_Send(datap+q*rbuffer.size(),rbuffer.size(),MPI_CHAR,other_node_,tag(),com);
+        MPI_Isend(sbuffer_.data()+chunks[n].first,chunks[n].second,MPI_CHAR,other_node_,tag(),com,&sreqs_[2+n]);
         }
-    MPI_Send(datap+quo*rbuffer.size(),rem,MPI_CHAR,other_node_,tag(),com);
     }
 
+void inline MailBox::
+send(std::stringstream const& data)
+    {
+    checkValid();
+    wait();
+    auto str = data.str();
+    sbuffer_.assign(str.begin(),str.end());
+    postSend();
+    }
 
 template <class T> 
 void inline MailBox::
 send(T const& obj)
     {
-    std::stringstream data; 
-    itensor::write(data,obj);
-    send(data); 
+    checkValid();
+    wait();
+    detail::writeBuffer(sbuffer_,obj);
+    postSend();
     }
 
 } //namespace itensor
@@ -0,0 +1,199 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_THREADPOOL_H
+#define __ITENSOR_THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "itensor/util/args.h"
+#include "itensor/util/timers.h"
+
+namespace itensor {
+namespace detail {
+
+//
+// Worker threads kept alive between parallel regions,
+// so that starting one (for example in every product
+// of a LocalMPO with "NThread" > 1) costs a few lock
+// operations rather than the creation of threads.
+//
+// The threads run alongside any threads of the BLAS,
+// so when using several of them it is usually best to
+// run the BLAS single-threaded (for example by setting
+// OMP_NUM_THREADS=1 or OPENBLAS_NUM_THREADS=1).
+//
+class ThreadPool
+    {
+    public:
+    using Task = std::function<void()>;
+    private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Task> tasks_;
+    std::vector<std::thread> workers_;
+    bool stop_ = false;
+    public:
+
+    ThreadPool()
+        {
+#ifdef COLLECT_TIMES
+        //Make the total of the timers first, so that
+        //it outlives the timers of the worker threads
+        detail::totalTimers();
+#endif
+        }
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool&
+    operator=(ThreadPool const&) = delete;
+
+    ~ThreadPool()
+        {
+            {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+            }
+        cv_.notify_all();
+        for(auto& w : workers_) w.join();
+        }
+
+    //Start worker threads until there are at least n
+    void
+    reserve(size_t n)
+        {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while(workers_.size() < n)
+            {
+            workers_.emplace_back([this] { work(); });
+            }
+        }
+
+    void
+    push(Task t)
+        {
+            {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(t));
+            }
+        cv_.notify_one();
+        }
+
+    //Run a queued task on the calling thread;
+    //returns false if there was none
+    bool
+    tryRun()
+        {
+        auto t = Task();
+            {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(tasks_.empty()) return false;
+            t = std::move(tasks_.front());
+            tasks_.pop_front();
+            }
+        t();
+        return true;
+        }
+
+    private:
+
+    void
+    work()
+        {
+        while(true)
+            {
+            auto t = Task();
+                {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock,[this] { return stop_ || !tasks_.empty(); });
+                if(tasks_.empty()) return;
+                t = std::move(tasks_.front());
+                tasks_.pop_front();
+                }
+            t();
+            }
+        }
+    };
+
+inline ThreadPool&
+threadPool()
+    {
+    static ThreadPool pool;
+    return pool;
+    }
+
+//
+// Run f(0), f(1), ..., f(n-1) concurrently, the last one
+// on the calling thread and the others on threads of
+// threadPool(). Each runs with the global Args of the
+// calling thread (see ScopedGlobalArgs). The first
+// exception thrown by any f(k) is rethrown once all
+// have finished.
+//
+template<typename Func>
+void
+parallelFor(size_t n, Func&& f)
+    {
+    if(n == 0) return;
+    if(n == 1)
+        {
+        f(0);
+        return;
+        }
+    auto& pool = threadPool();
+    pool.reserve(n-1);
+    auto* ga = ScopedGlobalArgs::threadGlobal();
+
+    std::mutex m;
+    std::condition_variable done;
+    auto left = n-1;
+    auto err = std::exception_ptr();
+    auto fail = [&]
+        {
+        std::lock_guard<std::mutex> lock(m);
+        if(!err) err = std::current_exception();
+        };
+    for(size_t k = 0; k+1 < n; ++k)
+        {
+        pool.push([&,k]
+            {
+            try
+                {
+                ScopedGlobalArgs sga(ga);
+                f(k);
+                }
+            catch(...)
+                {
+                fail();
+                }
+            std::lock_guard<std::mutex> lock(m);
+            if(--left == 0) done.notify_all();
+            });
+        }
+    try
+        {
+        f(n-1);
+        }
+    catch(...)
+        {
+        fail();
+        }
+    //Run queued tasks while waiting, so that nested
+    //calls of parallelFor cannot leave tasks waiting
+    //for a thread that is itself waiting
+    while(pool.tryRun()) { }
+    std::unique_lock<std::mutex> lock(m);
+    done.wait(lock,[&] { return left == 0; });
+    if(err) std::rethrow_exception(err);
+    }
+
+} //namespace detail
+} //namespace itensor
+
+#endif
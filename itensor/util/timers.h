@@ -7,6 +7,7 @@
 
 #include <chrono>
 #include <cmath>
+#include <mutex>
 #include "itensor/util/stdx.h"
 #include "itensor/util/print.h"
 
@@ -105,6 +106,18 @@ struct Timers
         count_[n] += 1ul;
         }
 
+    //Add the times and counts of other
+    void
+    merge(Timers const& other)
+        {
+        for(size_type n = 0; n < NTimer; ++n)
+            {
+            timer_[n] += other.timer_[n];
+            timer2_[n] += other.timer2_[n];
+            count_[n] += other.count_[n];
+            }
+        }
+
     size_t
     count(size_type n) const { return count_[n]; }
 
@@ -148,11 +161,48 @@ struct Timers
 
     };
 
+namespace detail {
+
+//Sum of the timers of the threads that have exited,
+//printed at the end of the program
+struct TotalTimers
+    {
+    GlobalTimer timers = GlobalTimer(true);
+    std::mutex mutex;
+    };
+
+inline TotalTimers&
+totalTimers()
+    {
+    static TotalTimers tt;
+    return tt;
+    }
+
+struct ThreadTimers
+    {
+    GlobalTimer timers;
+
+    //Make the total first, so that it outlives
+    //the timers of the main thread
+    ThreadTimers() { totalTimers(); }
+
+    ~ThreadTimers()
+        {
+        auto& tt = totalTimers();
+        std::lock_guard<std::mutex> lock(tt.mutex);
+        tt.timers.merge(timers);
+        }
+    };
+
+} //namespace detail
+
+//Timers of the calling thread; the times of all
+//threads are added up when they exit
 inline GlobalTimer & 
 timers()
     {
-    static GlobalTimer timers_(true);
-    return timers_;
+    static thread_local detail::ThreadTimers timers_;
+    return timers_.timers;
     }
 
 struct ScopedTimer
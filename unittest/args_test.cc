@@ -1,6 +1,7 @@
 #include "test.h"
 
 #include "itensor/global.h"
+#include <thread>
 
 using namespace std;
 using namespace itensor;
@@ -160,5 +161,34 @@ SECTION("Read/Write")
     CHECK(o2.getString("Name") == "name");
     }
 
-}
+SECTION("ScopedGlobalArgs")
+    {
+    Args::global().add("ScopedTest1",1);
+        {
+        ScopedGlobalArgs ga;
+        Global::args("ScopedTest2",2);
+        CHECK(Args::global().getInt("ScopedTest1") == 1);
+        CHECK(Args().getInt("ScopedTest2") == 2);
+            {
+            ScopedGlobalArgs inner;
+            Global::args("ScopedTest1",3);
+            CHECK(Args().getInt("ScopedTest1") == 3);
+            CHECK(Args().getInt("ScopedTest2") == 2);
+            }
+        CHECK(Args().getInt("ScopedTest1") == 1);
+        }
+    CHECK(!Args::global().defined("ScopedTest2"));
+
+    Args::global().remove("ScopedTest1");
+
+    //Another thread does not see the values set in a scope
+    auto seen = true;
+        {
+        ScopedGlobalArgs ga;
+        Global::args("ScopedTest2",2);
+        std::thread([&seen]{ seen = Args().defined("ScopedTest2"); }).join();
+        }
+    CHECK(!seen);
+    }
 
+}
@@ -1,8 +1,10 @@
 #include "test.h"
+#include <thread>
 #include "itensor/mps/autompo.h"
 #include "itensor/mps/sites/hubbard.h"
 #include "itensor/mps/sites/spinless.h"
 #include "itensor/mps/sites/spinhalf.h"
+#include "itensor/mps/lattice/square.h"
 #include "itensor/util/print_macro.h"
 
 #include "ExpIsing.h"
@@ -621,4 +623,484 @@ SECTION("Spinless")
     }
 
 
+SECTION("Bulk Add Terms")
+    {
+    auto N = 8;
+    auto sites = Hubbard(N);
+
+    //Reference built with +=, including out-of-order
+    //fermionic operators and duplicate terms
+    auto ampo = AutoMPO(sites);
+    for(auto i : range1(N))
+    for(auto j : range1(N))
+        {
+        if(i == j) continue;
+        auto t = 0.1*(i+2*j);
+        ampo += -t,"Cdagup",i,"Cup",j;
+        ampo += 0.5*t,"Cdn",j,"Cdagdn",i;
+        ampo += 0.3,"Nup",i,"Ndn",j;
+        }
+
+    auto bulk = AutoMPO(sites);
+    auto cdu = bulk.opId("Cdagup"),
+         cu = bulk.opId("Cup"),
+         cdd = bulk.opId("Cdagdn"),
+         cd = bulk.opId("Cdn"),
+         nu = bulk.opId("Nup"),
+         nd = bulk.opId("Ndn");
+    auto coefs = std::vector<Real>{};
+    auto ops = std::vector<int>{},
+         sts = std::vector<int>{};
+    for(auto i : range1(N))
+    for(auto j : range1(N))
+        {
+        if(i == j) continue;
+        auto t = 0.1*(i+2*j);
+        coefs.push_back(-t);
+        ops.insert(ops.end(),{cdu,cu});
+        sts.insert(sts.end(),{i,j});
+        coefs.push_back(0.5*t);
+        ops.insert(ops.end(),{cd,cdd});
+        sts.insert(sts.end(),{j,i});
+        }
+    bulk.addTerms(2,coefs,ops,sts,{"NThread",2});
+    //Add density terms in two halves to check merging
+    for(auto half : range(2))
+        {
+        coefs.clear();
+        ops.clear();
+        sts.clear();
+        for(auto i : range1(N))
+        for(auto j : range1(N))
+            {
+            if(i == j) continue;
+            coefs.push_back(half == 0 ? 0.1 : 0.2);
+            ops.insert(ops.end(),{nu,nd});
+            sts.insert(sts.end(),{i,j});
+            }
+        bulk.addTerms(2,coefs,ops,sts);
+        }
+    //Threads sharing a const AutoMPO with flat terms
+    auto shared = AutoMPO(sites);
+    for(auto op : {"Cdagup","Cup","Cdagdn","Cdn","Nup","Ndn"}) shared.opId(op);
+    shared.addTerms(2,coefs,ops,sts);
+    auto const& cshared = shared;
+    auto nterm = std::vector<size_t>(4);
+    auto threads = std::vector<std::thread>{};
+    for(auto t : range(nterm.size()))
+        {
+        threads.emplace_back([&,t] { nterm[t] = cshared.terms().size()+cshared.sortedTerms().size(); });
+        }
+    for(auto& th : threads) th.join();
+    for(auto n : nterm) CHECK(n == 2*coefs.size());
+
+    //A term added both with += and addTerms
+    ampo += 0.05,"Nup",1,"Ndn",2;
+    bulk += 0.05,"Nup",1,"Ndn",2;
+
+    //Made from the flat terms (merged with the others)
+    auto Hb = IQMPO(bulk);
+    auto sorted = bulk.sortedTerms();
+    CHECK(sorted.size() == size_t(ampo.size()));
+    auto st = sorted.begin();
+    for(auto& t : ampo.terms())
+        {
+        CHECK(t.ops == st->ops);
+        CHECK_CLOSE(t.coef,st->coef);
+        ++st;
+        }
+
+    CHECK(bulk.size() == ampo.size());
+    auto it = bulk.terms().begin();
+    for(auto& t : ampo.terms())
+        {
+        CHECK(t.ops == it->ops);
+        CHECK_CLOSE(t.coef,it->coef);
+        ++it;
+        }
+
+    auto H = IQMPO(ampo);
+    auto state = InitState(sites);
+    for(auto j : range1(N)) state.set(j,j%3==0 ? "UpDn" : (j%3==1 ? "Up" : "Emp"));
+    auto psi = IQMPS(state);
+    auto Hpsi = exactApplyMPO(psi,H);
+    CHECK_CLOSE(overlap(psi,H,psi),overlap(psi,Hb,psi));
+    CHECK_CLOSE(overlap(Hpsi,Hb,psi),overlap(Hpsi,H,psi));
+    }
+
+SECTION("Block Decomposition Options")
+    {
+    auto N = 10;
+    auto sites = SpinHalf(N);
+    auto ampo = AutoMPO(sites);
+    for(auto i : range1(N))
+    for(auto j : range1(i+1,N))
+        {
+        auto J = 1./((j-i)*(j-i));
+        ampo += 0.5*J,"S+",i,"S-",j;
+        ampo += 0.5*J,"S-",i,"S+",j;
+        ampo +=     J,"Sz",i,"Sz",j;
+        }
+    auto Hs = toMPO<IQTensor>(ampo,{"BlockDecomp","SVD"});
+    auto Hg = toMPO<IQTensor>(ampo,{"BlockDecomp","Gram"});
+    auto Ht = toMPO<IQTensor>(ampo,{"NThread",3});
+
+    for(auto b : range1(N-1))
+        {
+        auto ms = commonIndex(Hs.A(b),Hs.A(b+1),Link).m();
+        CHECK(commonIndex(Hg.A(b),Hg.A(b+1),Link).m() == ms);
+        CHECK(commonIndex(Ht.A(b),Ht.A(b+1),Link).m() == ms);
+        }
+
+    auto state = InitState(sites);
+    for(auto j : range1(N)) state.set(j,j%2==1 ? "Up" : "Dn");
+    auto psi = IQMPS(state);
+    auto Hpsi = exactApplyMPO(psi,Hs);
+    auto E = overlap(Hpsi,Hs,psi);
+    CHECK_CLOSE(overlap(Hpsi,Hg,psi),E);
+    CHECK_CLOSE(overlap(Hpsi,Ht,psi),E);
+
+    //Keeping null singular vectors: the link states they
+    //make must be as well defined as when using the SVD
+    auto nullStates = [](IQMPO const& H)
+        {
+        auto n = 0;
+        for(auto b : range1(2,H.N()))
+            {
+            auto A = toITensor(H.A(b));
+            auto l = Index(commonIndex(H.A(b-1),H.A(b),Link));
+            for(auto v : range1(l.m())) if(norm(A*setElt(l(v))) < 1E-10) ++n;
+            }
+        return n;
+        };
+    //(Sz1+Sz2)*(Sz3+Sz4+Sz5) has blocks of rank 1
+    auto arank = AutoMPO(sites);
+    for(auto i : range1(2))
+    for(auto j : range1(3,5))
+        {
+        arank += "Sz",i,"Sz",j;
+        }
+    auto allargs = Args("Minm",1000,"Cutoff",-1.);
+    auto Hsa = toMPO<IQTensor>(arank,{allargs,"BlockDecomp","SVD"});
+    auto Hga = toMPO<IQTensor>(arank,{allargs,"BlockDecomp","Gram"});
+    for(auto b : range1(N-1))
+        {
+        auto ms = commonIndex(Hsa.A(b),Hsa.A(b+1),Link).m();
+        CHECK(commonIndex(Hga.A(b),Hga.A(b+1),Link).m() == ms);
+        }
+    CHECK(nullStates(Hga) == nullStates(Hsa));
+    auto Er = overlap(Hpsi,Hsa,psi);
+    CHECK_CLOSE(overlap(Hpsi,Hga,psi),Er);
+    }
+
+SECTION("Long-Range Couplings")
+    {
+    auto maxLinkM = [](IQMPO const& H)
+        {
+        auto m = 0l;
+        for(auto b : range1(H.N()-1)) m = std::max(m,commonIndex(H.A(b),H.A(b+1),Link).m());
+        return m;
+        };
+
+    SECTION("Exponential Coupling")
+        {
+        //Each pair is fit exactly by one exponential
+        auto N = 12;
+        auto sites = SpinHalf(N);
+        auto V = [](int r) { return 0.8*std::pow(0.6,r); };
+        auto ampo = AutoMPO(sites);
+        ampo.addLongRange("S+","S-",[&V](int r) { return 0.5*V(r); });
+        ampo.addLongRange("S-","S+",[&V](int r) { return 0.5*V(r); });
+        ampo.addLongRange("Sz","Sz",V);
+        for(auto j : range1(N)) ampo += 0.3,"Sz",j;
+        auto H = toMPO<IQTensor>(ampo);
+        auto Ht = toMPO<IQTensor>(ampo,{"LongRange","Terms"});
+        CHECK(maxLinkM(H) == 5);
+
+        auto state = InitState(sites);
+        for(auto j : range1(N)) state.set(j,j%3==1 ? "Up" : "Dn");
+        auto psi = IQMPS(state);
+        auto Hpsi = exactApplyMPO(psi,Ht);
+        CHECK_CLOSE(overlap(psi,H,psi),overlap(psi,Ht,psi));
+        CHECK_CLOSE(overlap(Hpsi,H,psi),overlap(Hpsi,Ht,psi));
+        }
+
+    SECTION("Power Law")
+        {
+        auto N = 30;
+        auto sites = SpinHalf(N);
+        auto ampo = AutoMPO(sites);
+        auto V = [](int r) { return 1./(r*r); };
+        ampo.addLongRange("S+","S-",[&V](int r) { return 0.5*V(r); });
+        ampo.addLongRange("S-","S+",[&V](int r) { return 0.5*V(r); });
+        ampo.addLongRange("Sz","Sz",V);
+        auto H = toMPO<IQTensor>(ampo,{"LongRangeCutoff",1E-8});
+        auto Ht = toMPO<IQTensor>(ampo,{"LongRange","Terms"});
+        //Bond dimension is set by the number of
+        //exponentials, not the distance to the ends
+        for(auto b : range1(2,N-2))
+            {
+            CHECK(commonIndex(H.A(b),H.A(b+1),Link).m() == maxLinkM(H));
+            }
+
+        auto state = InitState(sites);
+        for(auto j : range1(N)) state.set(j,j%2==1 ? "Up" : "Dn");
+        auto psi = IQMPS(state);
+        auto Hpsi = exactApplyMPO(psi,Ht);
+        auto E = overlap(Hpsi,Ht,psi);
+        CHECK(std::fabs(overlap(Hpsi,H,psi)-E) < 1E-6*std::fabs(E));
+        }
+
+    SECTION("Fermions")
+        {
+        auto N = 10;
+        auto sites = Spinless(N);
+        auto V = [](int r) { return std::exp(-0.5*r)*std::cos(0.9*r); };
+        auto ampo = AutoMPO(sites);
+        ampo.addLongRange("Cdag","C",V);
+        ampo.addLongRange("C","Cdag",[&V](int r) { return -V(r); });
+        ampo.addLongRange("N","N",V);
+        for(auto j : range1(N-1))
+            {
+            ampo += -1.0,"Cdag",j,"C",j+1;
+            ampo += -1.0,"Cdag",j+1,"C",j;
+            }
+
+        auto state = InitState(sites);
+        for(auto j : range1(N)) state.set(j,(j%3==0 || j==4) ? "Occ" : "Emp");
+
+        auto H = toMPO<IQTensor>(ampo);
+        auto Ht = toMPO<IQTensor>(ampo,{"LongRange","Terms"});
+        auto psi = IQMPS(state);
+        auto Hpsi = exactApplyMPO(psi,Ht);
+        CHECK_CLOSE(overlap(Hpsi,H,psi),overlap(Hpsi,Ht,psi));
+
+        auto Hi = toMPO<ITensor>(ampo);
+        auto Hit = toMPO<ITensor>(ampo,{"LongRange","Terms"});
+        auto ipsi = MPS(state);
+        auto Hipsi = exactApplyMPO(ipsi,Hit);
+        CHECK_CLOSE(overlap(Hipsi,Hi,ipsi),overlap(Hipsi,Hit,ipsi));
+        }
+    }
+
+SECTION("Site Reordering")
+    {
+    auto Nx = 6,
+         Ny = 3;
+    auto N = Nx*Ny;
+    auto lattice = squareLattice(Nx,Ny);
+
+    //Scramble the usual ordering of the sites
+    auto order = std::vector<int>(N);
+    for(auto k : range(N)) order[k] = 1+(7*k)%N;
+    auto S = SitePermutation(order);
+    auto slattice = reorder(lattice,S);
+    CHECK(bandwidth(lattice,S) > Ny);
+
+    auto ident = SitePermutation(N);
+    for(auto method : {"CuthillMcKee","Fiedler","Best"})
+        {
+        auto P = siteOrdering(slattice,N,{"Method",method});
+        auto PS = reorder(slattice,P);
+        CHECK(maxCut(slattice,P) < maxCut(slattice,ident));
+        CHECK(bandwidth(PS,ident) == bandwidth(slattice,P));
+        for(auto j : range1(N)) CHECK(P.newSite(P.oldSite(j)) == j);
+        }
+    auto P = siteOrdering(slattice,N);
+    CHECK(bandwidth(slattice,P) <= Ny+1);
+
+    SECTION("Spins")
+        {
+        auto sites = SpinHalf(N);
+        auto ampo = AutoMPO(sites);
+        for(auto& b : slattice)
+            {
+            ampo += 0.5,"S+",b.s1,"S-",b.s2;
+            ampo += 0.5,"S-",b.s1,"S+",b.s2;
+            ampo +=     "Sz",b.s1,"Sz",b.s2;
+            }
+        CHECK(maxCut(interactionGraph(ampo),P) == maxCut(slattice,P));
+
+        auto H = toMPO<IQTensor>(ampo);
+        auto Hp = toMPO<IQTensor>(reorder(ampo,P));
+        auto maxm = [N](IQMPO const& W)
+            {
+            auto m = 0l;
+            for(auto b : range1(N-1)) m = std::max(m,commonIndex(W.A(b),W.A(b+1),Link).m());
+            return m;
+            };
+        CHECK(maxm(Hp) < maxm(H));
+
+        //Same product state in the two orderings
+        auto state = InitState(sites);
+        auto pstate = InitState(sites);
+        for(auto i : range1(N))
+            {
+            auto up = (i%3 != 0);
+            state.set(i,up ? "Up" : "Dn");
+            pstate.set(P.newSite(i),up ? "Up" : "Dn");
+            }
+        auto psi = IQMPS(state);
+        auto ppsi = IQMPS(pstate);
+        CHECK_CLOSE(overlap(psi,H,psi),overlap(ppsi,Hp,ppsi));
+        auto Hpsi = exactApplyMPO(psi,H);
+        auto Hppsi = exactApplyMPO(ppsi,Hp);
+        CHECK_CLOSE(overlap(Hpsi,H,psi),overlap(Hppsi,Hp,ppsi));
+        }
+
+    SECTION("Fermions")
+        {
+        //<psi|H^4|psi> includes hopping around plaquettes,
+        //so depends on the signs of the reordered terms
+        auto Nf = 8;
+        auto forder = std::vector<int>(Nf);
+        for(auto k : range(Nf)) forder[k] = 1+(3*k)%Nf;
+        auto flattice = reorder(squareLattice(4,2),SitePermutation(forder));
+        auto Pf = siteOrdering(flattice,Nf);
+
+        auto sites = Spinless(Nf);
+        auto ampo = AutoMPO(sites);
+        for(auto& b : flattice)
+            {
+            ampo += -1.0,"Cdag",b.s1,"C",b.s2;
+            ampo += -1.0,"Cdag",b.s2,"C",b.s1;
+            ampo +=  0.5,"N",b.s1,"N",b.s2;
+            }
+        auto H = toMPO<IQTensor>(ampo);
+        auto Hp = toMPO<IQTensor>(reorder(ampo,Pf));
+
+        auto state = InitState(sites);
+        auto pstate = InitState(sites);
+        for(auto i : range1(Nf))
+            {
+            auto occ = (i%3 == 0 || i == 5);
+            state.set(i,occ ? "Occ" : "Emp");
+            pstate.set(Pf.newSite(i),occ ? "Occ" : "Emp");
+            }
+        auto psi = IQMPS(state);
+        auto ppsi = IQMPS(pstate);
+        auto Hpsi = exactApplyMPO(psi,H);
+        auto Hppsi = exactApplyMPO(ppsi,Hp);
+        CHECK_CLOSE(overlap(Hpsi,H,psi),overlap(Hppsi,Hp,ppsi));
+        auto H2psi = exactApplyMPO(Hpsi,H);
+        auto H2ppsi = exactApplyMPO(Hppsi,Hp);
+        CHECK_CLOSE(overlap(H2psi,H2psi),overlap(H2ppsi,H2ppsi));
+        }
+    }
+
+SECTION("Cached and Updated MPOs")
+    {
+    auto N = 10;
+    auto makeAmpo = [N](SiteSet const& sites, Cplx J2)
+        {
+        auto ampo = AutoMPO(sites);
+        for(auto j : range1(N-1))
+            {
+            auto J = 1.+0.1*j;
+            ampo += 0.5*J,"S+",j,"S-",j+1;
+            ampo += 0.5*J,"S-",j,"S+",j+1;
+            ampo +=     J,"Sz",j,"Sz",j+1;
+            if(j < N-1) ampo += J2,"Sz",j,"Sz",j+2;
+            }
+        return ampo;
+        };
+    auto sites = SpinHalf(N);
+    auto state = InitState(sites);
+    for(auto j : range1(N)) state.set(j,j%3==1 ? "Up" : "Dn");
+    auto psi = IQMPS(state);
+
+    SECTION("Cache")
+        {
+        auto dir = mkTempDir("mpocache","/tmp/");
+        auto H1 = toMPO<IQTensor>(makeAmpo(sites,0.3),{"CacheDir",dir});
+        auto Hpsi = exactApplyMPO(psi,H1);
+        auto E = overlap(Hpsi,H1,psi);
+
+        //Read back from the cache with a new SiteSet
+        auto sites2 = SpinHalf(N);
+        auto H2 = toMPO<IQTensor>(makeAmpo(sites2,0.3),{"CacheDir",dir});
+        CHECK(hasindex(H2.A(1),sites2(1)));
+        auto state2 = InitState(sites2);
+        for(auto j : range1(N)) state2.set(j,j%3==1 ? "Up" : "Dn");
+        auto psi2 = IQMPS(state2);
+        CHECK_CLOSE(overlap(exactApplyMPO(psi2,H2),H2,psi2),E);
+
+        //Read back with the same SiteSet, getting new links
+        auto H1b = toMPO<IQTensor>(makeAmpo(sites,0.3),{"CacheDir",dir});
+        auto H1c = toMPO<IQTensor>(makeAmpo(sites,0.3),{"CacheDir",dir});
+        CHECK(hasindex(H1b.A(1),sites(1)));
+        CHECK_CLOSE(overlap(Hpsi,H1b,psi),E);
+        for(auto n : range1(N-1))
+            {
+            auto l = commonIndex(H1b.A(n),H1b.A(n+1),Link);
+            CHECK(l != commonIndex(H1c.A(n),H1c.A(n+1),Link));
+            CHECK(l != commonIndex(H1.A(n),H1.A(n+1),Link));
+            }
+
+        //Different coefficients are cached separately
+        auto H3 = toMPO<IQTensor>(makeAmpo(sites,0.5),{"CacheDir",dir});
+        auto H3r = toMPO<IQTensor>(makeAmpo(sites,0.5));
+        CHECK_CLOSE(overlap(Hpsi,H3,psi),overlap(Hpsi,H3r,psi));
+
+        auto iH1 = toMPO<ITensor>(makeAmpo(sites,0.3),{"CacheDir",dir});
+        auto iH2 = toMPO<ITensor>(makeAmpo(sites2,0.3),{"CacheDir",dir});
+        auto ipsi2 = MPS(state2);
+        CHECK_CLOSE(overlap(ipsi2,iH2,ipsi2),overlap(psi,H1,psi));
+        auto iH1b = toMPO<ITensor>(makeAmpo(sites,0.3),{"CacheDir",dir});
+        auto ipsi = MPS(state);
+        CHECK_CLOSE(overlap(ipsi,iH1b,ipsi),overlap(psi,H1,psi));
+
+        //Infinite MPOs (with boundary tensors) are not cached
+        for(int k = 0; k < 2; ++k)
+            {
+            auto Hi = toMPO<IQTensor>(makeAmpo(sites,0.3),{"Infinite",true,"CacheDir",dir});
+            CHECK(Hi.A(0));
+            CHECK(Hi.A(N+1));
+            }
+
+        std::system(("rm -rf "+dir).c_str());
+
+        //An unwritable cache directory only gives a warning
+        auto Hn = toMPO<IQTensor>(makeAmpo(sites,0.3),{"CacheDir",dir+"/missing"});
+        CHECK_CLOSE(overlap(Hpsi,Hn,psi),overlap(Hpsi,H1,psi));
+        }
+
+    SECTION("Coefficient Update")
+        {
+        auto U = MPOUpdater<IQTensor>(makeAmpo(sites,0.3));
+        auto H = U.mpo(makeAmpo(sites,0.3));
+        auto links = std::vector<IQIndex>(N);
+        for(auto n : range1(N-1)) links[n] = commonIndex(H.A(n),H.A(n+1),Link);
+
+        //Same MPO as made by toMPO
+        auto a2 = makeAmpo(sites,0.7);
+        auto H2 = toMPO<IQTensor>(a2);
+        auto Hpsi = exactApplyMPO(psi,H2);
+        auto Hu = U.mpo(a2);
+        for(auto n : range1(N-1))
+            {
+            auto m = commonIndex(H2.A(n),H2.A(n+1),Link).m();
+            CHECK(commonIndex(Hu.A(n),Hu.A(n+1),Link).m() == m);
+            }
+        CHECK_CLOSE(overlap(Hpsi,Hu,psi),overlap(Hpsi,H2,psi));
+
+        //Keeping the links of H
+        CHECK(U.update(a2,H));
+        for(auto n : range1(N-1)) CHECK(commonIndex(H.A(n),H.A(n+1),Link) == links[n]);
+        CHECK_CLOSE(overlap(Hpsi,H,psi),overlap(Hpsi,H2,psi));
+        CHECK_CLOSE(overlap(psi,H,psi),overlap(psi,H2,psi));
+
+        //Complex coefficients
+        auto ac = makeAmpo(sites,0.7+0.2_i);
+        auto Hc = toMPO<IQTensor>(ac);
+        CHECK_CLOSE(overlapC(Hpsi,U.mpo(ac),psi),overlapC(Hpsi,Hc,psi));
+
+        auto iU = MPOUpdater<ITensor>(makeAmpo(sites,0.3));
+        auto iH = iU.mpo(makeAmpo(sites,0.3));
+        CHECK(iU.update(a2,iH));
+        auto ipsi = MPS(state);
+        CHECK_CLOSE(overlap(ipsi,iH,ipsi),overlap(psi,H2,psi));
+        }
+    }
+
 }
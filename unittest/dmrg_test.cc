@@ -0,0 +1,206 @@
+#include "test.h"
+#include "itensor/mps/dmrg.h"
+#include "itensor/mps/autompo.h"
+#include "itensor/mps/sites/spinhalf.h"
+#include "itensor/mps/sites/spinone.h"
+#include <thread>
+
+using namespace itensor;
+
+TEST_CASE("DMRGTest")
+{
+
+auto N = 10;
+auto sites = SpinHalf(N);
+
+auto ampo = AutoMPO(sites);
+for(int j = 1; j < N; ++j)
+    {
+    ampo += 0.5,"S+",j,"S-",j+1;
+    ampo += 0.5,"S-",j,"S+",j+1;
+    ampo +=     "Sz",j,"Sz",j+1;
+    }
+
+auto state = InitState(sites);
+for(int j = 1; j <= N; ++j) state.set(j,j%2==1 ? "Up" : "Dn");
+
+//Exact ground state energy of the N=10
+//open Heisenberg chain
+auto exact_energy = -4.258035207282883;
+
+SECTION("Two-site DMRG")
+    {
+    auto H = IQMPO(ampo);
+    auto psi = IQMPS(state);
+    auto sweeps = Sweeps(5);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-12;
+    auto energy = dmrg(psi,H,sweeps,{"Quiet",true});
+    CHECK_DIFF(energy,exact_energy,1E-12);
+    }
+
+SECTION("One-site DMRG with subspace expansion")
+    {
+    SECTION("IQMPS")
+        {
+        auto H = IQMPO(ampo);
+        auto psi = IQMPS(state);
+        auto sweeps = Sweeps(8);
+        sweeps.maxm() = 10,20,40;
+        sweeps.cutoff() = 1E-12;
+        sweeps.noise() = 1E-1,1E-2,1E-4,1E-6,1E-8,0.;
+        sweeps.numCenter() = 1;
+        auto energy = dmrg(psi,H,sweeps,{"Quiet",true});
+        CHECK(maxM(psi) > 1);
+        CHECK_DIFF(energy,exact_energy,1E-12);
+        CHECK_DIFF(overlap(psi,H,psi),exact_energy,1E-12);
+        }
+
+    SECTION("MPS")
+        {
+        auto H = MPO(ampo);
+        auto psi = MPS(state);
+        auto sweeps = Sweeps(8);
+        sweeps.maxm() = 10,20,40;
+        sweeps.cutoff() = 1E-12;
+        sweeps.noise() = 1E-1,1E-2,1E-4,1E-6,1E-8,0.;
+        sweeps.numCenter() = 1;
+        auto energy = dmrg(psi,H,sweeps,{"Quiet",true});
+        CHECK_DIFF(energy,exact_energy,1E-12);
+        }
+    }
+
+SECTION("Sum of MPOs")
+    {
+    auto axy = AutoMPO(sites);
+    auto azz = AutoMPO(sites);
+    for(int j = 1; j < N; ++j)
+        {
+        axy += 0.5,"S+",j,"S-",j+1;
+        axy += 0.5,"S-",j,"S+",j+1;
+        azz +=     "Sz",j,"Sz",j+1;
+        }
+    auto Hset = std::vector<IQMPO>{IQMPO(axy),IQMPO(azz)};
+    auto sweeps = Sweeps(5);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-12;
+    for(auto nt : {1,2})
+        {
+        auto psi = IQMPS(state);
+        auto energy = dmrg(psi,Hset,sweeps,{"Quiet",true,"NThread",nt});
+        CHECK_DIFF(energy,exact_energy,1E-12);
+        }
+    }
+
+SECTION("Mixed one- and two-site sweeps")
+    {
+    auto H = IQMPO(ampo);
+    auto psi = IQMPS(state);
+    auto sweeps = Sweeps(6);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-12;
+    sweeps.numCenter() = 2,1,2,1;
+    sweeps.noise() = 1E-6,1E-8,0.;
+    auto energy = dmrg(psi,H,sweeps,{"Quiet",true});
+    CHECK_DIFF(energy,exact_energy,1E-12);
+    }
+
+SECTION("Record Spectra")
+    {
+    auto H = IQMPO(ampo);
+    auto psi = IQMPS(state);
+    auto sweeps = Sweeps(5);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-12;
+    auto obs = DMRGObserver<IQTensor>(psi,{"RecordSpectra",true});
+    dmrg(psi,H,sweeps,obs,{"Quiet",true,"ComputeQNs",true});
+    auto specs = bondSpectra(psi);
+    for(auto b : range1(N-1))
+        {
+        CHECK(obs.spectrum(b).hasQNs());
+        CHECK(std::fabs(entropy(obs.spectrum(b))-entropy(specs[b])) < 1E-6);
+        }
+    }
+
+SECTION("Concurrent DMRG")
+    {
+    //Independent calculations sharing H, each thread
+    //with its own random numbers and global Args
+    auto H = IQMPO(ampo);
+    auto nthread = 4;
+    auto energies = std::vector<Real>(nthread);
+    auto rands = std::vector<Real>(nthread);
+    auto threads = std::vector<std::thread>{};
+    for(auto t : range(nthread))
+        {
+        threads.emplace_back([&,t]
+            {
+            ScopedGlobalArgs ga;
+            Global::args("Quiet",true);
+            Global::args("ConcurrentTest",t);
+            seedRNG(7);
+            rands[t] = Global::random();
+            auto psi = IQMPS(state);
+            auto sweeps = Sweeps(5);
+            sweeps.maxm() = 10,20,40;
+            sweeps.cutoff() = 1E-12;
+            energies[t] = dmrg(psi,H,sweeps);
+            });
+        }
+    for(auto& th : threads) th.join();
+    for(auto t : range(nthread))
+        {
+        CHECK_DIFF(energies[t],exact_energy,1E-12);
+        CHECK(rands[t] == rands[0]);
+        }
+    CHECK(!Args::global().defined("ConcurrentTest"));
+    }
+
+SECTION("Read/Write Sweeps")
+    {
+    auto sweeps = Sweeps(4);
+    sweeps.maxm() = 10,20;
+    sweeps.numCenter() = 2,1;
+    std::stringstream data;
+    sweeps.write(data);
+    auto sw2 = Sweeps();
+    sw2.read(data);
+    CHECK(sw2.nsweep() == 4);
+    CHECK(sw2.maxm(2) == 20);
+    CHECK(sw2.numCenter(1) == 2);
+    CHECK(sw2.numCenter(4) == 1);
+
+    //Sweeps written without the number of center sites
+    std::stringstream old;
+    auto n = 3;
+    auto ivec = std::vector<int>(n+1,10);
+    auto rvec = std::vector<Real>(n+1,1E-8);
+    write(old,ivec);
+    write(old,ivec);
+    write(old,rvec);
+    write(old,ivec);
+    write(old,rvec);
+    write(old,n);
+    //followed by other data
+    write(old,ivec);
+    auto sw3 = Sweeps();
+    sw3.read(old);
+    CHECK(sw3.nsweep() == 3);
+    CHECK(sw3.maxm(3) == 10);
+    for(auto sw : range1(3)) CHECK(sw3.numCenter(sw) == 2);
+    auto after = std::vector<int>{};
+    read(old,after);
+    CHECK(after == ivec);
+
+    //New Sweeps followed by other data
+    std::stringstream both;
+    sweeps.write(both);
+    write(both,ivec);
+    auto sw4 = Sweeps();
+    sw4.read(both);
+    CHECK(sw4.numCenter(4) == 1);
+    read(both,after);
+    CHECK(after == ivec);
+    }
+
+}
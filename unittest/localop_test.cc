@@ -2,6 +2,8 @@
 #include "itensor/mps/localop.h"
 #include "itensor/mps/localmpo.h"
 #include "itensor/mps/sites/spinhalf.h"
+#include "itensor/mps/autompo.h"
+#include "itensor/mps/dmrg.h"
 #include "itensor/util/print_macro.h"
 
 using namespace itensor;
@@ -54,6 +56,30 @@ SECTION("Product")
         CHECK(hasindex(Hpsi,l0));
         CHECK(hasindex(Hpsi,l2));
         }
+
+    SECTION("Contraction Order")
+        {
+        auto Op1 = randomTensor(s1,prime(s1),h0,h1);
+        auto Op2 = randomTensor(s2,prime(s2),h1,h2);
+        auto L = randomTensor(l0,prime(l0),h0);
+        auto R = randomTensor(l2,prime(l2),h2);
+        auto psi = randomTensor(l0,s1,s2,l2);
+        auto exact = noprime(psi*L*Op1*Op2*R);
+
+        auto lop = LocalOp<ITensor>(Op1,Op2,L,R);
+        auto Hpsi = ITensor();
+        lop.product(psi,Hpsi);
+        CHECK(norm(Hpsi-exact) < 1E-10*norm(exact));
+        //Second call reuses the cached order
+        lop.product(psi,Hpsi);
+        CHECK(norm(Hpsi-exact) < 1E-10*norm(exact));
+
+        auto ROp2 = R*Op2;
+        auto lop1 = LocalOp<ITensor>();
+        lop1.update(Op1,L,ROp2);
+        lop1.product(psi,Hpsi);
+        CHECK(norm(Hpsi-exact) < 1E-10*norm(exact));
+        }
     }
 
 SECTION("Diag")
@@ -109,6 +135,97 @@ SECTION("LocalMPO As MPS")
     auto lmps = LocalMPO<IQTensor>(psiN);
     lmps.position(3,psiF);
     }
+
+SECTION("Product Matches Fixed Order")
+    {
+    auto N = 8;
+    auto sites = SpinHalf(N);
+    auto ampo = AutoMPO(sites);
+    for(int j = 1; j < N; ++j)
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto H = IQMPO(ampo);
+    auto state = InitState(sites);
+    for(int j = 1; j <= N; ++j) state.set(j,j%2==1 ? "Up" : "Dn");
+    auto psi = IQMPS(state);
+    dmrg(psi,H,Sweeps(2),{"Quiet",true});
+
+    auto PH = LocalMPO<IQTensor>(H);
+    for(auto b : {1,4,N-1})
+        {
+        PH.position(b,psi);
+        auto phi = psi.A(b)*psi.A(b+1);
+        auto Hphi = IQTensor();
+        PH.product(phi,Hphi);
+        auto exact = phi*H.A(b)*H.A(b+1);
+        if(PH.L()) exact *= PH.L();
+        if(PH.R()) exact *= PH.R();
+        exact.mapprime(1,0);
+        CHECK(norm(Hphi-exact) < 1E-10*norm(exact));
+        }
+    }
+
+SECTION("Parallel Product")
+    {
+    auto N = 8;
+    auto sites = SpinHalf(N);
+    auto ampo = AutoMPO(sites);
+    for(int j = 1; j < N; ++j)
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto state = InitState(sites);
+    for(int j = 1; j <= N; ++j) state.set(j,j%2==1 ? "Up" : "Dn");
+
+    SECTION("IQTensor")
+        {
+        auto H = IQMPO(ampo);
+        auto psi = IQMPS(state);
+        dmrg(psi,H,Sweeps(2),{"Quiet",true});
+        for(auto nc : {1,2})
+            {
+            auto PH = LocalMPO<IQTensor>(H,{"NumCenter",nc});
+            auto PHt = LocalMPO<IQTensor>(H,{"NumCenter",nc,"NThread",3});
+            for(auto b : {4,1,N-nc+1,3})
+                {
+                PH.position(b,psi);
+                PHt.position(b,psi);
+                if(PH.L()) CHECK(norm(PH.L()-PHt.L()) < 1E-12*norm(PH.L()));
+                if(PH.R()) CHECK(norm(PH.R()-PHt.R()) < 1E-12*norm(PH.R()));
+                auto phi = psi.A(b);
+                if(nc == 2) phi *= psi.A(b+1);
+                IQTensor Hphi,Hphit;
+                PH.product(phi,Hphi);
+                PHt.product(phi,Hphit);
+                CHECK(norm(Hphi-Hphit) < 1E-12*norm(Hphi));
+                }
+            }
+        }
+
+    SECTION("ITensor")
+        {
+        auto H = MPO(ampo);
+        auto psi = MPS(state);
+        dmrg(psi,H,Sweeps(2),{"Quiet",true});
+        auto PH = LocalMPO<ITensor>(H);
+        auto PHt = LocalMPO<ITensor>(H,{"NThread",4});
+        for(auto b : {4,2})
+            {
+            PH.position(b,psi);
+            PHt.position(b,psi);
+            auto phi = psi.A(b)*psi.A(b+1);
+            ITensor Hphi,Hphit;
+            PH.product(phi,Hphi);
+            PHt.product(phi,Hphit);
+            CHECK(norm(Hphi-Hphit) < 1E-12*norm(Hphi));
+            }
+        }
+    }
 }
 
 
@@ -0,0 +1,111 @@
+#include "test.h"
+#include "itensor/mps/metts.h"
+#include "itensor/mps/dmrg.h"
+#include "itensor/mps/autompo.h"
+#include "itensor/mps/sites/spinhalf.h"
+
+using namespace itensor;
+
+TEST_CASE("METTSTest")
+{
+auto N = 4;
+auto sites = SpinHalf(N);
+auto ampo = AutoMPO(sites);
+for(int j = 1; j < N; ++j)
+    {
+    ampo += 0.5,"S+",j,"S-",j+1;
+    ampo += 0.5,"S-",j,"S+",j+1;
+    ampo +=     "Sz",j,"Sz",j+1;
+    }
+auto H = MPO(ampo);
+
+auto state = InitState(sites);
+for(int j = 1; j <= N; ++j) state.set(j,j%2==1 ? "Up" : "Dn");
+auto psi0 = MPS(state);
+
+SECTION("Collapse Z")
+    {
+    auto psi = psi0;
+    auto rng = std::mt19937(1);
+    auto st = collapse(psi,"Z",rng);
+    for(auto j : range1(N)) CHECK(st.at(j) == (j%2==1 ? 1 : 2));
+    CHECK_CLOSE(overlap(psi,psi0),1.);
+    for(auto b : range1(N-1)) CHECK(linkInd(psi,b).m() == 1);
+    }
+
+SECTION("Collapse Singlet")
+    {
+    //Collapsing the ground state of two sites (a singlet)
+    //gives opposite states in either basis
+    auto s2 = SpinHalf(2);
+    auto ampo2 = AutoMPO(s2);
+    ampo2 += 0.5,"S+",1,"S-",2;
+    ampo2 += 0.5,"S-",1,"S+",2;
+    ampo2 +=     "Sz",1,"Sz",2;
+    auto H2 = MPO(ampo2);
+    auto psi = MPS(s2);
+    auto sweeps = Sweeps(4);
+    sweeps.maxm() = 4;
+    dmrg(psi,H2,sweeps,{"Quiet",true});
+
+    auto rng = std::mt19937(7);
+    auto nup = 0;
+    for(auto n : range(40))
+        {
+        auto phi = psi;
+        auto st = collapse(phi,n%2==0 ? "Z" : "X",rng);
+        CHECK(st.at(1) != st.at(2));
+        CHECK_CLOSE(norm(phi.A(1)*phi.A(2)),1.);
+        if(st.at(1) == 1) ++nup;
+        }
+    CHECK(nup > 5);
+    CHECK(nup < 35);
+    }
+
+SECTION("Thermal Energy")
+    {
+    auto beta = 1.;
+    auto tau = 0.1;
+    auto expH = toExpH<ITensor>(ampo,tau);
+    auto nstep = int(beta/2/tau+0.5);
+
+    //Exact thermal energy
+    auto Hfull = H.A(1);
+    for(auto j : range1(2,N)) Hfull *= H.A(j);
+    auto rho = expHermitian(Hfull,-beta);
+    auto trace = [&sites,N](ITensor X)
+        {
+        for(auto j : range1(N)) X *= delta(dag(sites(j)),prime(sites(j)));
+        return X.cplx().real();
+        };
+    auto HR = Hfull*prime(rho);
+    HR.mapprime(2,1);
+    auto Eexact = trace(HR)/trace(rho);
+
+    auto args = Args{"NChain",4,"NMETTS",60,"NWarm",3,"Seed",11,
+                     "Cutoff",1E-12,"Maxm",32,"Quiet",true};
+    auto res = metts(psi0,expH,nstep,{H},args);
+    CHECK(res.nchain() == 4);
+    CHECK(res.count() == 240);
+    for(auto c : range(4)) CHECK(res.count(c) == 60);
+    CHECK(res.err(0) > 0);
+    CHECK(std::fabs(res.avg(0)-Eexact) < 4*res.err(0)+0.02);
+
+    //Chains have their own random numbers, so the
+    //results do not depend on the number of threads
+    args.add("NThread",2);
+    auto res2 = metts(psi0,expH,nstep,{H},args);
+    CHECK(res2.avg(0) == res.avg(0));
+    CHECK(res2.err(0) == res.err(0));
+    for(auto c : range(4)) CHECK(res2.avg(c,0) == res.avg(c,0));
+
+    args.add("Seed",12);
+    auto res3 = metts(psi0,expH,nstep,{H},args);
+    CHECK(res3.avg(0) != res.avg(0));
+
+    auto both = res;
+    both.merge(res3);
+    CHECK(both.count() == 480);
+    CHECK_CLOSE(both.avg(0),(res.avg(0)+res3.avg(0))/2);
+    }
+}
@@ -0,0 +1,390 @@
+//
+// Tests of the MPI communication in itensor/util/parallel.h.
+// Built separately from the other tests (they do not need MPI);
+// run with "make mpitest", which uses mpirun on the local machine.
+//
+#define CATCH_CONFIG_RUNNER
+#include "test.h"
+#include <set>
+#include "itensor/util/parallel.h"
+#include "itensor/mps/localmpo_mpi.h"
+#include "itensor/mps/pdmrg.h"
+#include "itensor/mps/metts_mpi.h"
+#include "itensor/mps/autompo.h"
+#include "itensor/mps/sites/spinhalf.h"
+
+using namespace itensor;
+
+//Small Bufsize so messages are split into many chunks
+Environment* penv = nullptr;
+
+int
+main(int argc, char* argv[])
+    {
+    Environment env(argc,argv,{"Bufsize",1000});
+    penv = &env;
+    return Catch::Session().run(argc,argv);
+    }
+
+//Tensor with the same elements on every node,
+//large enough to take many chunks
+ITensor
+testTensor(Index const& i, Index const& j, Real shift)
+    {
+    auto T = ITensor(i,j);
+    for(auto a : range1(i))
+    for(auto b : range1(j))
+        {
+        T.set(i(a),j(b),std::sin(a+0.1*b+shift));
+        }
+    return T;
+    }
+
+TEST_CASE("MPITest")
+{
+auto& env = *penv;
+auto i = Index("i",60),
+     j = Index("j",70);
+//Index ids are random, so make them the same on every node
+broadcast(env,i,j);
+
+SECTION("Broadcast ITensor")
+    {
+    auto ref = testTensor(i,j,0.);
+    auto T = env.firstNode() ? ref : ITensor();
+    env.broadcast(T);
+    CHECK(hasindex(T,i));
+    CHECK(hasindex(T,j));
+    CHECK(norm(T-ref) < 1E-14);
+    }
+
+SECTION("Broadcast IQMPS")
+    {
+    auto sites = SpinHalf(10);
+    auto state = InitState(sites);
+    for(auto n : range1(10)) state.set(n,n%2==1 ? "Up" : "Dn");
+    auto psi = IQMPS();
+    if(env.firstNode()) psi = IQMPS(state);
+    broadcast(env,psi);
+    CHECK(psi.N() == 10);
+    CHECK_CLOSE(overlap(psi,psi),1.);
+    CHECK(totalQN(psi) == QN("Sz=",0));
+    }
+
+SECTION("Broadcast Stringstream")
+    {
+    auto msg = std::string(5000,'x')+"end";
+    std::stringstream s;
+    if(env.firstNode()) s << msg;
+    env.broadcast(s);
+    CHECK(s.str() == msg);
+    }
+
+SECTION("MailBox Ring")
+    {
+    //Every node sends to its right neighbor before receiving
+    //from its left one, which only works since sends do not block
+    auto ring = [&](MailBox& out, MailBox& in)
+        {
+        for(auto n : range(3))
+            {
+            out.send(testTensor(i,j,env.rank()+n));
+            auto T = ITensor();
+            in.receive(T);
+            CHECK(norm(T-testTensor(i,j,env.lnode()+n)) < 1E-14);
+            }
+        };
+    if(env.nnodes() == 2)
+        {
+        MailBox box(env,env.rnode());
+        ring(box,box);
+        }
+    else if(env.nnodes() > 2)
+        {
+        MailBox rbox(env,env.rnode());
+        MailBox lbox(env,env.lnode());
+        ring(rbox,lbox);
+        }
+    }
+
+SECTION("Scatter and Gather")
+    {
+    auto v = std::vector<Real>{};
+    auto n = 1000*env.nnodes()+7;
+    if(env.firstNode()) for(auto k : range(n)) v.push_back(k);
+    scatterVector(env,v);
+    gatherVector(env,v);
+    if(env.firstNode())
+        {
+        REQUIRE(v.size() == size_t(n));
+        for(auto k : range(n)) CHECK(v[k] == k);
+        }
+    }
+
+SECTION("Sum")
+    {
+    auto T = testTensor(i,j,0.);
+    auto S = allSum(env,T);
+    CHECK(norm(S-env.nnodes()*T) < 1E-12*norm(S));
+    }
+
+SECTION("AllReduce ITensor")
+    {
+    auto r = env.rank();
+    //Index order differs between nodes
+    auto T = testTensor(i,j,r);
+    if(r%2 == 1) T.order(j,i);
+    T *= 2.;
+    allReduce(env,T);
+    auto S = ITensor(i,j);
+    for(auto n : range(env.nnodes())) S += 2.*testTensor(i,j,n);
+    CHECK(norm(T-S) < 1E-12*norm(S));
+
+    auto M = testTensor(i,j,r);
+    allReduce(env,M,MPI_MAX);
+    for(auto a : range1(i))
+    for(auto b : range1(j))
+        {
+        auto x = std::sin(a+0.1*b);
+        for(auto n : range1(env.nnodes()-1)) x = std::max(x,std::sin(a+0.1*b+n));
+        CHECK_CLOSE(M.real(i(a),j(b)),x);
+        }
+    }
+
+SECTION("AllReduce Complex ITensor")
+    {
+    //Complex on only one node
+    auto T = testTensor(i,j,0.);
+    if(env.lastNode()) T *= Cplx(0.,1.);
+    allReduce(env,T);
+    auto ref = testTensor(i,j,0.)*Cplx(env.nnodes()-1,1.);
+    CHECK(isComplex(T));
+    CHECK(norm(T-ref) < 1E-12*norm(ref));
+    }
+
+SECTION("AllReduce IQTensor")
+    {
+    auto I = IQIndex("I",Index("I+",2),QN(+1),Index("I0",3),QN(0),Index("I-",4),QN(-1)),
+         J = IQIndex("J",Index("J+",5),QN(+1),Index("J-",6),QN(-1));
+    broadcast(env,I,J);
+    auto T = randomTensor(QN(),I,dag(J));
+    broadcast(env,T);
+    auto U = (env.rank()+1.)*T;
+    if(env.rank()%2 == 1) U.order(dag(J),I);
+    allReduce(env,U);
+    auto n = env.nnodes();
+    CHECK(div(U) == QN());
+    CHECK(norm(U-(n*(n+1)/2.)*T) < 1E-12*norm(U));
+    }
+
+SECTION("Reduce and ReduceScatter")
+    {
+    auto r = env.rank(),
+         n = env.nnodes();
+    auto T = testTensor(i,j,0.);
+    auto R = (r+1.)*T;
+    reduce(env,R,n-1);
+    if(env.lastNode()) CHECK(norm(R-(n*(n+1)/2.)*T) < 1E-12*norm(R));
+    else               CHECK(norm(R-(r+1.)*T) < 1E-12*norm(R));
+
+    auto v = std::vector<ITensor>{};
+    for(auto k : range(n)) v.push_back(testTensor(i,j,k+r));
+    auto S = reduceScatter(env,v);
+    auto ref = ITensor(i,j);
+    for(auto q : range(n)) ref += testTensor(i,j,r+q);
+    CHECK(norm(S-ref) < 1E-12*norm(ref));
+    }
+
+SECTION("AllReduce Null ITensor")
+    {
+    auto i = Index("i",3),
+         j = Index("j",4);
+    broadcast(env,i,j);
+    auto T = ITensor();
+    if(!env.firstNode()) T = setElt(i(2),j(3));
+    allReduce(env,T);
+    CHECK(T);
+    CHECK_CLOSE(T.real(i(2),j(3)),env.nnodes()-1.);
+    CHECK_CLOSE(norm(T),env.nnodes()-1.);
+
+    auto Z = ITensor();
+    allReduce(env,Z);
+    CHECK(!Z);
+    }
+
+SECTION("Distributed Environments")
+    {
+    auto N = 10;
+    auto sites = SpinHalf(N);
+    broadcast(env,sites);
+    auto ampo = AutoMPO(sites);
+    for(auto j : range1(N-1))
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto H = IQMPO(ampo);
+    auto state = InitState(sites);
+    for(auto n : range1(N)) state.set(n,n%2==1 ? "Up" : "Dn");
+
+    auto sweeps = Sweeps(5);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-12;
+
+    //Serial DMRG with the tensors of node 0
+    auto phi = IQMPS(state);
+    detail::broadcastTensors(env,phi);
+    detail::broadcastTensors(env,H);
+    auto E0 = dmrg(phi,H,sweeps,{"Quiet",true});
+
+    auto psi = IQMPS(state);
+    auto E = dmrg(env,psi,H,sweeps,{"Quiet",true});
+    CHECK(std::fabs(E-E0) < 1E-10*std::fabs(E0));
+    CHECK_CLOSE(overlap(psi,psi),1.);
+    CHECK(std::fabs(std::fabs(overlap(phi,psi))-1.) < 1E-8);
+
+    //Indices made afterwards do not repeat the ids of the
+    //indices made during the sweeps
+    auto linkIDs = std::set<Index::id_type>{};
+    for(auto b : range1(N-1))
+        {
+        auto l = linkInd(psi,b);
+        linkIDs.insert(l.id());
+        for(auto iq : l) linkIDs.insert(iq.index.id());
+        }
+    auto repeats = 0;
+    for(auto n : range(5000))
+        {
+        (void)n;
+        if(linkIDs.count(Index("x",2).id())) ++repeats;
+        }
+    CHECK(repeats == 0);
+    }
+
+SECTION("Distributed Environments Complex")
+    {
+    auto N = 8;
+    auto sites = SpinHalf(N);
+    broadcast(env,sites);
+    auto ampo = AutoMPO(sites);
+    for(auto j : range1(N-1))
+        {
+        ampo += Cplx(0.4,0.3),"S+",j,"S-",j+1;
+        ampo += Cplx(0.4,-0.3),"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto H = IQMPO(ampo);
+    auto state = InitState(sites);
+    for(auto n : range1(N)) state.set(n,n%2==1 ? "Up" : "Dn");
+    auto sweeps = Sweeps(5);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-12;
+
+    auto phi = IQMPS(state);
+    detail::broadcastTensors(env,phi);
+    detail::broadcastTensors(env,H);
+    auto E0 = dmrg(phi,H,sweeps,{"Quiet",true});
+    auto psi = IQMPS(state);
+    auto E = dmrg(env,psi,H,sweeps,{"Quiet",true});
+    CHECK(std::fabs(E-E0) < 1E-10*std::fabs(E0));
+    }
+
+SECTION("Distributed Products")
+    {
+    auto N = 8;
+    auto sites = SpinHalf(N);
+    broadcast(env,sites);
+    auto ampo = AutoMPO(sites);
+    for(auto j : range1(N-1))
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto H = MPO(ampo);
+    auto psi = MPS(sites);
+    detail::broadcastTensors(env,H);
+    auto sweeps = Sweeps(2);
+    sweeps.maxm() = 8;
+    dmrg(psi,H,sweeps,{"Quiet",true});
+    detail::broadcastTensors(env,psi);
+
+    for(auto nc : {1,2})
+        {
+        auto PH = LocalMPO<ITensor>(H,{"NumCenter",nc});
+        auto PM = LocalMPO_MPI<ITensor>(env,H,{"NumCenter",nc});
+        for(auto b : range1(N-nc+1))
+            {
+            PH.position(b,psi);
+            PM.position(b,psi);
+            auto phi = (nc == 2) ? psi.A(b)*psi.A(b+1) : psi.A(b);
+            //Later products reuse the layouts of the first
+            for(auto& phix : {phi,phi,Cplx(0.5,2.)*phi})
+                {
+                ITensor Hphi,Mphi;
+                PH.product(phix,Hphi);
+                PM.product(phix,Mphi);
+                CHECK(norm(Hphi-Mphi) < 1E-10*norm(Hphi));
+                }
+            }
+        }
+    }
+
+SECTION("METTS")
+    {
+    auto N = 4;
+    auto sites = SpinHalf(N);
+    auto ampo = AutoMPO(sites);
+    for(auto j : range1(N-1))
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto H = MPO(ampo);
+    auto expH = toExpH<ITensor>(ampo,0.1);
+    auto state = InitState(sites);
+    for(auto n : range1(N)) state.set(n,n%2==1 ? "Up" : "Dn");
+    auto psi0 = MPS(state);
+
+    auto args = Args{"NChain",5,"NMETTS",8,"NWarm",2,"Seed",3,"Quiet",true};
+    auto res = metts(env,psi0,expH,5,{H},args);
+    auto ser = metts(psi0,expH,5,{H},args);
+    CHECK(res.count() == 40);
+    for(auto c : range(5)) CHECK(res.count(c) == 8);
+    CHECK_CLOSE(res.avg(0),ser.avg(0));
+    CHECK_CLOSE(res.err(0),ser.err(0));
+    }
+
+SECTION("Parallel DMRG")
+    {
+    auto N = 12;
+    //Every node needs the same sites
+    auto sites = SpinHalf(N);
+    broadcast(env,sites);
+    auto ampo = AutoMPO(sites);
+    for(auto j : range1(N-1))
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto H = IQMPO(ampo);
+    auto state = InitState(sites);
+    for(auto n : range1(N)) state.set(n,n%2==1 ? "Up" : "Dn");
+
+    auto sweeps = Sweeps(10);
+    sweeps.maxm() = 10,20,40,80;
+    sweeps.cutoff() = 1E-12;
+
+    auto phi = IQMPS(state);
+    auto E0 = dmrg(phi,H,sweeps,{"Quiet",true});
+
+    auto psi = IQMPS(state);
+    auto E = parallelDMRG(env,psi,H,sweeps,{"Quiet",true});
+    CHECK(std::fabs(E-E0) < 1E-5*std::fabs(E0));
+    CHECK_CLOSE(overlap(psi,psi),1.);
+    CHECK(totalQN(psi) == QN("Sz=",0));
+    }
+}
@@ -5,6 +5,7 @@
 #include "itensor/util/print_macro.h"
 #include "itensor/mps/sites/hubbard.h"
 #include "itensor/mps/autompo.h"
+#include "itensor/mps/sharedtensors.h"
 
 using namespace itensor;
 using namespace std;
@@ -210,4 +211,101 @@ SECTION("toMPO function")
 
     }
 
+SECTION("Shared Tensors")
+    {
+    auto N = 20;
+    auto sites = SpinHalf(N);
+    auto ampo = AutoMPO(sites);
+    for(int j = 1; j < N; ++j)
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto state = InitState(sites);
+    for(auto j : range1(N)) state.set(j,j%2==1 ? "Up" : "Dn");
+    auto psi = IQMPS(state);
+
+    auto H = IQMPO(ampo);
+    auto Hs = H;
+    CHECK(numDistinctTensors(Hs) == N);
+    //Bulk tensors are all shared; the ends differ
+    CHECK(shareTensors(Hs) == 3);
+    CHECK_CLOSE(overlap(psi,Hs,psi),overlap(psi,H,psi));
+    for(auto j : range1(N)) CHECK(norm(Hs.A(j)-H.A(j)) < 1E-12);
+
+    //Modifying a tensor does not affect the others
+    Hs.Aref(5) += H.A(5);
+    CHECK(numDistinctTensors(Hs) == 4);
+    CHECK(norm(Hs.A(6)-H.A(6)) < 1E-12);
+    CHECK(norm(Hs.A(5)-2.*H.A(5)) < 1E-12);
+
+    auto Hm = MPO(ampo);
+    CHECK(shareTensors(Hm,{"Period",1}) == 3);
+    auto phi = MPS(state);
+    CHECK_CLOSE(overlap(phi,Hm,phi),overlap(psi,H,psi));
+    }
+
+SECTION("Variance")
+    {
+    auto N = 10;
+    auto sites = SpinHalf(N);
+    auto ampo = AutoMPO(sites);
+    for(int j = 1; j < N; ++j)
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto H = IQMPO(ampo);
+    auto state = InitState(sites);
+    for(auto j : range1(N)) state.set(j,j%2==1 ? "Up" : "Dn");
+    auto psi = IQMPS(state);
+
+    //H|Neel> = -(N-1)/4|Neel> plus N-1 orthogonal states
+    //with one flipped pair, each with amplitude 1/2
+    auto exact = (N-1)/4.;
+    CHECK_CLOSE(variance(psi,H),exact);
+    CHECK_CLOSE(variance(psi,H,{"Method","Fit","Maxm",50,"Cutoff",1E-14,"Nsweep",2}),exact);
+    CHECK_CLOSE(variance(psi,H,{"Method","ZipUp","Maxm",50,"Cutoff",1E-14}),exact);
+    CHECK_CLOSE(variance(2.*psi,H),exact);
+    }
+
+SECTION("Krylov Exponential")
+    {
+    auto N = 8;
+    auto sites = SpinHalf(N);
+    auto ampo = AutoMPO(sites);
+    for(int j = 1; j < N; ++j)
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    for(int j = 1; j+3 <= N; ++j) ampo += 0.3,"Sz",j,"Sz",j+3;
+    auto H = IQMPO(ampo);
+    auto state = InitState(sites);
+    for(auto j : range1(N)) state.set(j,j%2==1 ? "Up" : "Dn");
+    auto psi = IQMPS(state);
+
+    auto full = [N](IQMPS const& phi)
+        {
+        auto T = toITensor(phi.A(1));
+        for(auto j : range1(2,N)) T *= toITensor(phi.A(j));
+        return T;
+        };
+    auto Hfull = toITensor(H.A(1));
+    for(auto j : range1(2,N)) Hfull *= toITensor(H.A(j));
+
+    auto args = Args("Cutoff",1E-14,"MaxIter",20);
+    for(auto t : {Cplx(0,-0.5),Cplx(-0.5,0)})
+        {
+        auto exact = noprime(expHermitian(Hfull,t)*full(psi));
+        IQMPS res;
+        auto err = applyExpKrylov(psi,H,t,res,args);
+        CHECK(err < 1E-10);
+        CHECK(norm(full(res)-exact) < 1E-5*norm(exact));
+        }
+    }
+
 }
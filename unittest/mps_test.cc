@@ -2,6 +2,10 @@
 #include "itensor/mps/mps.h"
 #include "itensor/mps/sites/spinhalf.h"
 #include "itensor/mps/sites/spinless.h"
+#include "itensor/mps/correlations.h"
+#include "itensor/mps/sampling.h"
+#include "itensor/mps/dmrg.h"
+#include "itensor/mps/autompo.h"
 #include "itensor/util/print_macro.h"
 
 using namespace itensor;
@@ -144,4 +148,203 @@ SECTION("Overlap - 1 site")
     CHECK_CLOSE(overlap(psi,psi),(psi.A(1)*psi.A(1)).real());
     }
 
+SECTION("Correlation Matrix")
+    {
+    auto sweeps = Sweeps(4);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-12;
+
+    //Entry (i,j) computed separately as <psi|A_i B_j|psi>
+    auto pairValue = [](IQMPS const& psi, std::string A, int i, std::string B, int j)
+        {
+        auto ampo = AutoMPO(psi.sites());
+        ampo += A,i,B,j;
+        return overlapC(psi,IQMPO(ampo),psi);
+        };
+
+    SECTION("Spins")
+        {
+        auto ampo = AutoMPO(shsites);
+        for(auto j : range1(N-1))
+            {
+            ampo += 0.5,"S+",j,"S-",j+1;
+            ampo += 0.5,"S-",j,"S+",j+1;
+            ampo +=     "Sz",j,"Sz",j+1;
+            }
+        auto psi = IQMPS(shNeel);
+        dmrg(psi,IQMPO(ampo),sweeps,{"Quiet",true});
+
+        auto C = correlationMatrices(psi,{{"Sz","Sz"},{"S+","S-"}});
+        for(auto i : range1(N))
+            {
+            //The ground state has total Sz = 0
+            auto row = Cplx(0.);
+            for(auto j : range1(N)) row += C[0](i-1,j-1);
+            CHECK(std::abs(row) < 1E-8);
+            for(auto j : range1(N))
+                {
+                CHECK(std::abs(C[1](i-1,j-1)-pairValue(psi,"S+",i,"S-",j)) < 1E-10);
+                }
+            }
+        CHECK_CLOSE(C[0](2,2).real(),0.25);
+
+        auto C2 = correlationMatrix(psi,"S+","S-",{"NThread",2});
+        CHECK(norm(C2-C[1]) < 1E-12);
+        }
+
+    SECTION("Fermions")
+        {
+        auto sites = Spinless(N);
+        auto ampo = AutoMPO(sites);
+        for(auto j : range1(N-1))
+            {
+            ampo += -1.,"Cdag",j,"C",j+1;
+            ampo += -1.,"Cdag",j+1,"C",j;
+            ampo += 0.3,"N",j,"N",j+1;
+            }
+        auto state = InitState(sites);
+        for(auto j : range1(N)) state.set(j,j%2==1 ? "Occ" : "Emp");
+        auto psi = IQMPS(state);
+        dmrg(psi,IQMPO(ampo),sweeps,{"Quiet",true});
+
+        auto C = correlationMatrix(psi,"Cdag","C",{"Fermionic",true});
+        for(auto i : range1(N))
+        for(auto j : range1(N))
+            {
+            CHECK(std::abs(C(i-1,j-1)-pairValue(psi,"Cdag",i,"C",j)) < 1E-10);
+            }
+        }
+    }
+
+SECTION("Bond Spectra")
+    {
+    auto ampo = AutoMPO(shsites);
+    for(auto j : range1(N-1))
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto sweeps = Sweeps(4);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-12;
+    auto psi = IQMPS(shNeel);
+    dmrg(psi,IQMPO(ampo),sweeps,{"Quiet",true});
+    psi.position(N);
+
+    auto specs = bondSpectra(psi);
+    CHECK(specs.size() == size_t(N));
+    for(auto b : range1(N-1))
+        {
+        //Compare with the spectrum found by moving
+        //the orthogonality center to bond b
+        auto phi = psi;
+        phi.position(b);
+        auto U = phi.A(b);
+        IQTensor D,V;
+        auto spec = svd(phi.A(b)*phi.A(b+1),U,D,V,{"Truncate",false});
+        auto& p = specs[b];
+        //(up to eigenvalues that vanish to machine precision)
+        auto neig = std::max(p.numEigsKept(),spec.numEigsKept());
+        for(auto n : range1(neig))
+            {
+            auto pn = (n <= p.numEigsKept()) ? p.eig(n) : 0.;
+            auto sn = (n <= spec.numEigsKept()) ? spec.eig(n) : 0.;
+            CHECK(std::fabs(pn-sn) < 1E-12);
+            }
+        CHECK_CLOSE(entropy(p),entropy(spec));
+
+        Real p2 = 0;
+        for(auto n : range1(p.numEigsKept())) p2 += sqr(p.eig(n));
+        CHECK_CLOSE(entropy(p,2.),-std::log(p2));
+
+        Real w = 0;
+        for(auto& qw : qnWeights(p)) w += qw.second;
+        CHECK_CLOSE(w,1.);
+        }
+    //Sz of sites 1,...,b is +1/2 or -1/2 with equal weight for odd b
+    auto w1 = qnWeights(specs[1]);
+    REQUIRE(w1.size() == 2);
+    CHECK_CLOSE(w1[0].second,0.5);
+
+    auto trunc = bondSpectra(psi,{"Maxm",2});
+    CHECK(trunc[N/2].numEigsKept() == 2);
+    CHECK_CLOSE(trunc[N/2].truncerr()+trunc[N/2].eig(1)+trunc[N/2].eig(2),1.);
+    }
+
+SECTION("Sampling")
+    {
+    auto n = 4;
+    auto sites = SpinHalf(n);
+    auto ampo = AutoMPO(sites);
+    for(auto j : range1(n-1))
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto neel = InitState(sites);
+    for(auto j : range1(n)) neel.set(j,j%2==1 ? "Up" : "Dn");
+
+    //Compare the frequencies of the configurations
+    //drawn with their probabilities |<c|psi>|^2
+    auto checkFrequencies = [&sites,n](ITensor F, std::vector<std::vector<int>> const& samples)
+        {
+        F /= norm(F);
+        auto ns = Real(samples.size());
+        auto freq = std::vector<Real>(16,0.);
+        for(auto& c : samples) freq.at((c[1]-1)+2*(c[2]-1)+4*(c[3]-1)+8*(c[4]-1)) += 1./ns;
+        for(auto k : range(16))
+            {
+            auto s = [&sites,k](int j) { return Index(sites(j))(1+((k >> (j-1)) & 1)); };
+            auto p = std::norm(F.cplx(s(1),s(2),s(3),s(4)));
+            CHECK(std::fabs(freq[k]-p) < 5*std::sqrt(p*(1-p)/ns)+1E-3);
+            }
+        };
+
+    auto sweeps = Sweeps(4);
+    sweeps.maxm() = 10;
+    sweeps.cutoff() = 1E-12;
+    auto psi = IQMPS(neel);
+    dmrg(psi,IQMPO(ampo),sweeps,{"Quiet",true});
+    psi.position(n);
+
+    auto samples = sample(psi,20000,{"Seed",1,"NThread",2,"BatchSize",100});
+    REQUIRE(samples.size() == 20000);
+    auto nup = 0;
+    for(auto& c : samples) for(auto j : range1(n)) if(c[j] == 1) ++nup;
+    CHECK(nup == 20000*n/2);
+    auto F = psi.A(1);
+    for(auto j : range1(2,n)) F *= psi.A(j);
+    checkFrequencies(toITensor(F),samples);
+
+    //The configurations drawn depend on the seed
+    //but not on the number of threads
+    auto S = MPSSampler<IQMPS>(psi);
+    auto s1 = S.sample(300,{"Seed",3,"NThread",1,"BatchSize",16});
+    CHECK(S.sample(300,{"Seed",3,"NThread",3,"BatchSize",16}) == s1);
+    CHECK(S.sample(300,{"Seed",4,"BatchSize",16}) != s1);
+    auto rng = std::mt19937(5);
+    CHECK(S.sample(10,rng).size() == 10);
+
+    //A product state gives itself
+    for(auto& c : sample(MPS(neel),50))
+        {
+        for(auto j : range1(n)) CHECK(c[j] == (j%2==1 ? 1 : 2));
+        }
+
+    //Complex amplitudes
+    auto phi = MPS(neel);
+    auto expH = toExpH<ITensor>(ampo,Cplx(0.1,0.3));
+    for(auto t : range(3))
+        {
+        (void)t;
+        phi = exactApplyMPO(expH,phi,{"Cutoff",1E-14});
+        }
+    auto G = phi.A(1);
+    for(auto j : range1(2,n)) G *= phi.A(j);
+    CHECK(isComplex(G));
+    checkFrequencies(G,sample(phi,20000,{"Seed",2}));
+    }
+
 }
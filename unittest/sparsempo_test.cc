@@ -0,0 +1,108 @@
+#include "test.h"
+#include "itensor/mps/sparsempo.h"
+#include "itensor/mps/localsparsempo.h"
+#include "itensor/mps/dmrg.h"
+#include "itensor/mps/autompo.h"
+#include "itensor/mps/sites/spinhalf.h"
+
+using namespace itensor;
+
+TEST_CASE("SparseMPOTest")
+{
+
+auto N = 8;
+auto sites = SpinHalf(N);
+
+//J1-J2 Heisenberg chain
+auto ampo = AutoMPO(sites);
+for(int j = 1; j < N; ++j)
+    {
+    ampo += 0.5,"S+",j,"S-",j+1;
+    ampo += 0.5,"S-",j,"S+",j+1;
+    ampo +=     "Sz",j,"Sz",j+1;
+    }
+for(int j = 1; j < N-1; ++j)
+    {
+    ampo += 0.25,"S+",j,"S-",j+2;
+    ampo += 0.25,"S-",j,"S+",j+2;
+    ampo += 0.5, "Sz",j,"Sz",j+2;
+    }
+
+auto state = InitState(sites);
+for(int j = 1; j <= N; ++j) state.set(j,j%2==1 ? "Up" : "Dn");
+
+SECTION("Constructor")
+    {
+    auto H = IQMPO(ampo);
+    auto sH = SparseIQMPO(H);
+    CHECK(sH.N() == N);
+    CHECK(sH.rows(1) == 1);
+    CHECK(sH.cols(N) == 1);
+    for(int j = 2; j < N; ++j)
+        {
+        auto hl = commonIndex(H.A(j-1),H.A(j),Link);
+        auto hr = commonIndex(H.A(j),H.A(j+1),Link);
+        CHECK(sH.rows(j) == hl.m());
+        CHECK(sH.cols(j) == hr.m());
+        //AutoMPO tensors are mostly zero...
+        CHECK(sH.numNonZero(j) < hl.m()*hr.m());
+        //...and contain at least two identities
+        CHECK(sH.numIdentity(j) >= 2);
+        }
+    }
+
+SECTION("Product and Environments")
+    {
+    auto H = IQMPO(ampo);
+    auto sH = SparseIQMPO(H);
+    auto psi = IQMPS(state);
+    dmrg(psi,H,Sweeps(2),{"Quiet",true});
+
+    for(auto nc : {1,2})
+        {
+        auto PH = LocalMPO<IQTensor>(H,{"NumCenter",nc});
+        auto sPH = LocalSparseMPO<IQTensor>(sH,{"NumCenter",nc});
+        for(auto b : {1,3,N-nc+1,2})
+            {
+            PH.position(b,psi);
+            sPH.position(b,psi);
+            auto phi = psi.A(b);
+            if(nc == 2) phi *= psi.A(b+1);
+            CHECK(sPH.size() == PH.size());
+            IQTensor Hphi,sHphi;
+            PH.product(phi,Hphi);
+            sPH.product(phi,sHphi);
+            CHECK(norm(Hphi-sHphi) < 1E-10*norm(Hphi));
+            }
+        }
+    }
+
+SECTION("DMRG")
+    {
+    auto H = IQMPO(ampo);
+    auto sweeps = Sweeps(5);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-12;
+    sweeps.noise() = 1E-8,0.;
+
+    auto psi = IQMPS(state);
+    auto energy = dmrg(psi,H,sweeps,{"Quiet",true});
+
+    auto spsi = IQMPS(state);
+    auto senergy = dmrg(spsi,SparseIQMPO(H),sweeps,{"Quiet",true});
+    CHECK_DIFF(senergy,energy,1E-10);
+    CHECK_DIFF(overlap(spsi,H,spsi),energy,1E-10);
+
+    auto sweeps1 = sweeps;
+    sweeps1.numCenter() = 1;
+    sweeps1.noise() = 1E-1,1E-3,1E-6,1E-8,0.;
+    auto sH = SparseMPO(MPO(ampo));
+    //sH keeps its own copy of the SiteSet
+    CHECK(sH.sites().N() == N);
+    CHECK(sH.sites()(1) == sites(1));
+    auto psi1 = MPS(state);
+    auto energy1 = dmrg(psi1,sH,sweeps1,{"Quiet",true});
+    CHECK_DIFF(energy1,energy,1E-8);
+    }
+
+}
@@ -0,0 +1,96 @@
+#include "test.h"
+#include "itensor/mps/tdvp.h"
+#include "itensor/mps/autompo.h"
+#include "itensor/mps/sites/spinhalf.h"
+
+using namespace itensor;
+
+TEST_CASE("TDVPTest")
+{
+
+SECTION("Imaginary Time")
+    {
+    auto N = 10;
+    auto sites = SpinHalf(N);
+    auto ampo = AutoMPO(sites);
+    for(int j = 1; j < N; ++j)
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto H = IQMPO(ampo);
+    auto state = InitState(sites);
+    for(int j = 1; j <= N; ++j) state.set(j,j%2==1 ? "Up" : "Dn");
+    auto psi = IQMPS(state);
+
+    auto sweeps = Sweeps(20);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-12;
+    auto energy = tdvp(psi,H,-1.,sweeps,{"Quiet",true});
+    CHECK_CLOSE(energy,overlap(psi,H,psi));
+    CHECK_DIFF(energy,-4.258035207282883,1E-3);
+    }
+
+//Real-time evolution compared to
+//exponentiating the full Hamiltonian
+auto N = 6;
+auto sites = SpinHalf(N);
+auto ampo = AutoMPO(sites);
+for(int j = 1; j < N; ++j)
+    {
+    ampo += 0.5,"S+",j,"S-",j+1;
+    ampo += 0.5,"S-",j,"S+",j+1;
+    ampo +=     "Sz",j,"Sz",j+1;
+    }
+for(int j = 1; j+2 <= N; ++j) ampo += 0.4,"Sz",j,"Sz",j+2;
+ampo += 0.3,"Sx",1;
+auto H = MPO(ampo);
+
+auto state = InitState(sites);
+for(int j = 1; j <= N; ++j) state.set(j,j%2==1 ? "Up" : "Dn");
+auto psi0 = MPS(state);
+auto E0 = overlap(psi0,H,psi0);
+
+auto full = [N](MPS const& psi)
+    {
+    auto T = psi.A(1);
+    for(auto j : range1(2,N)) T *= psi.A(j);
+    return T;
+    };
+auto Hfull = H.A(1);
+for(auto j : range1(2,N)) Hfull *= H.A(j);
+
+auto ttotal = 1.;
+auto dt = 0.1;
+auto exact = noprime(expHermitian(Hfull,Cplx(0,-ttotal))*full(psi0));
+
+SECTION("Two-site Real Time")
+    {
+    auto psi = psi0;
+    auto sweeps = Sweeps(10);
+    sweeps.maxm() = 64;
+    sweeps.cutoff() = 1E-14;
+    auto energy = tdvp(psi,H,Cplx(0,-dt),sweeps,{"Quiet",true});
+    CHECK_CLOSE(energy,E0);
+    CHECK(norm(full(psi)-exact) < 1E-3);
+    }
+
+SECTION("One-site Real Time")
+    {
+    //Grow psi to the full bond dimension
+    //first (time step zero), after which
+    //one-site TDVP is exact
+    auto psi = psi0;
+    auto grow = Sweeps(2);
+    grow.maxm() = 64;
+    grow.cutoff() = 0;
+    tdvp(psi,H,Cplx(0,0),grow,{"Quiet",true});
+
+    auto sweeps = Sweeps(10);
+    sweeps.setnumCenter(1);
+    auto energy = tdvp(psi,H,Cplx(0,-dt),sweeps,{"Quiet",true});
+    CHECK_CLOSE(energy,E0);
+    CHECK(norm(full(psi)-exact) < 1E-8);
+    }
+}
@@ -0,0 +1,104 @@
+#include "test.h"
+#include "itensor/mps/tevol.h"
+#include "itensor/mps/gatecircuit.h"
+#include "itensor/mps/sites/spinhalf.h"
+
+using namespace itensor;
+
+TEST_CASE("GateTEvolTest")
+{
+auto N = 10;
+auto sites = SpinHalf(N);
+auto state = InitState(sites);
+for(int j = 1; j <= N; ++j) state.set(j,j%2==1 ? "Up" : "Dn");
+
+auto tstep = 0.02;
+auto ttotal = 0.4;
+
+//Second-order Trotter step: odd bonds,
+//even bonds, then odd bonds again
+auto makeGates = [&](IQGate::Type type)
+    {
+    auto gates = std::vector<IQGate>{};
+    auto addGate = [&](int b, Real tau)
+        {
+        auto hh = sites.op("Sz",b)*sites.op("Sz",b+1)
+                + 0.5*sites.op("S+",b)*sites.op("S-",b+1)
+                + 0.5*sites.op("S-",b)*sites.op("S+",b+1);
+        gates.push_back(IQGate(sites,b,b+1,type,tau,hh));
+        };
+    for(int b = 1; b < N; b += 2) addGate(b,tstep/2.);
+    for(int b = 2; b < N; b += 2) addGate(b,tstep);
+    for(int b = N-1; b >= 1; b -= 2) addGate(b,tstep/2.);
+    return gates;
+    };
+
+auto args = Args("Cutoff",1E-12,"Maxm",100,"ShowPercent",false);
+
+SECTION("Layered Real Time")
+    {
+    auto gates = makeGates(IQGate::tReal);
+    auto psi = IQMPS(state);
+    gateTEvol(gates,ttotal,tstep,psi,args);
+
+    for(auto regauge : {true,false})
+        {
+        auto phi = IQMPS(state);
+        gateTEvol(gates,ttotal,tstep,phi,{args,"Method","Layered","NThread",3,"Regauge",regauge});
+        CHECK_CLOSE(norm(phi),1.);
+        CHECK_CLOSE(std::abs(overlapC(psi,phi)),1.);
+        }
+    }
+
+SECTION("Layered Imaginary Time")
+    {
+    auto gates = makeGates(IQGate::tImag);
+    auto psi = IQMPS(state);
+    auto nrm = gateTEvol(gates,ttotal,tstep,psi,args);
+
+    auto phi = IQMPS(state);
+    auto lnrm = gateTEvol(gates,ttotal,tstep,phi,{args,"Method","Layered","NThread",3});
+    CHECK_DIFF(lnrm/nrm,1.,1E-5);
+    CHECK_CLOSE(std::abs(overlapC(psi,phi)),1.);
+    }
+
+SECTION("Compiled Gates")
+    {
+    auto hh = [&](int b)
+        {
+        return sites.op("Sz",b)*sites.op("Sz",b+1)
+             + 0.5*sites.op("S+",b)*sites.op("S-",b+1)
+             + 0.5*sites.op("S-",b)*sites.op("S+",b+1);
+        };
+    auto cache = BondGateCache<IQTensor>(sites);
+    auto gates = std::vector<IQGate>{},
+         ref = std::vector<IQGate>{};
+    auto add = [&](int b, Real tau, IQTensor const& H)
+        {
+        gates.push_back(cache.gate(b,b+1,IQGate::tReal,tau,H));
+        ref.push_back(IQGate(sites,b,b+1,IQGate::tReal,tau,H));
+        };
+    for(int b = 1; b < N; ++b) add(b,tstep/2.,hh(b));
+    //Swap, gate, swap on one bond; two swaps on another
+    gates.push_back(IQGate(sites,3,4));
+    add(3,tstep,hh(3)+sites.op("Sz",3)*sites.op("Id",4));
+    gates.push_back(IQGate(sites,3,4));
+    gates.push_back(IQGate(sites,6,7));
+    gates.push_back(IQGate(sites,6,7));
+    for(int b = N-1; b >= 1; --b) add(b,tstep/2.,hh(b));
+    CHECK(cache.size() == 2);
+
+    auto compiled = compileGates(sites,gates);
+    CHECK(compiled.size() == gates.size()-5);
+
+    auto swap = IQGate(sites,3,4);
+    ref.insert(ref.begin()+N-1,swap);
+    ref.insert(ref.begin()+N+1,swap);
+
+    auto psi = IQMPS(state);
+    gateTEvol(ref,ttotal,tstep,psi,args);
+    auto phi = IQMPS(state);
+    gateTEvol(compiled,ttotal,tstep,phi,args);
+    CHECK_CLOSE(std::abs(overlapC(psi,phi)),1.);
+    }
+}
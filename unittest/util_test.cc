@@ -3,6 +3,7 @@
 #include "itensor/global.h"
 #include "itensor/util/infarray.h"
 #include "itensor/util/stats.h"
+#include "itensor/util/threadpool.h"
 
 using namespace itensor;
 using namespace std;
@@ -261,3 +262,53 @@ SECTION("BinErr")
     }
 }
 
+TEST_CASE("ParallelFor")
+{
+
+SECTION("Runs Each Once")
+    {
+    auto n = 5;
+    auto count = std::vector<int>(n,0);
+    for(auto rep : range(3))
+        {
+        (void)rep;
+        detail::parallelFor(n,[&count](size_t k) { count[k] += 1; });
+        }
+    for(auto k : range(n)) CHECK(count[k] == 3);
+    }
+
+SECTION("Nested")
+    {
+    //More nested tasks than threads in the pool
+    auto sums = std::vector<long>(4,0);
+    detail::parallelFor(4,[&sums](size_t k)
+        {
+        auto parts = std::vector<long>(6,0);
+        detail::parallelFor(6,[&parts,k](size_t j) { parts[j] = long(10*k+j); });
+        for(auto p : parts) sums[k] += p;
+        });
+    for(auto k : range(4)) CHECK(sums[k] == 60*long(k)+15);
+    }
+
+SECTION("Exceptions")
+    {
+    auto ran = std::vector<int>(3,0);
+    CHECK_THROWS(detail::parallelFor(3,[&ran](size_t k)
+        {
+        ran[k] = 1;
+        if(k == 0) throw std::runtime_error("failed");
+        }));
+    for(auto r : ran) CHECK(r == 1);
+    }
+
+SECTION("Global Args")
+    {
+    //Tasks see the global Args of the calling thread
+    ScopedGlobalArgs ga;
+    Global::args("ParallelForTest",7);
+    auto vals = std::vector<long>(3,0);
+    detail::parallelFor(3,[&vals](size_t k) { vals[k] = Args().getInt("ParallelForTest",0); });
+    for(auto v : vals) CHECK(v == 7);
+    }
+
+}